@@ -2,7 +2,7 @@
 #include "CollisionVolume.h"
 #include "../../Common/Vector3.h"
 namespace NCL {
-	class AABBVolume : CollisionVolume
+	class AABBVolume : CollisionVolume, public CSC8503::PooledComponent<AABBVolume>
 	{
 	public:
 		AABBVolume(const Vector3& halfDims) {
@@ -0,0 +1,209 @@
+#include "BatchCollision.h"
+#include <cmath>
+#include <algorithm>
+
+// MSVC lets AVX2 intrinsics be used without /arch:AVX2, GCC and clang need them enabled per function
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define BATCH_COLLISION_AVX2
+#define AVX2_FUNCTION
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BATCH_COLLISION_AVX2
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+
+using namespace NCL;
+using namespace CSC8503;
+
+void SphereSphereBatch::Clear() {
+	posAX.clear(); posAY.clear(); posAZ.clear(); radiusA.clear();
+	posBX.clear(); posBY.clear(); posBZ.clear(); radiusB.clear();
+}
+
+void SphereSphereBatch::Add(const Vector3& posA, float radA, const Vector3& posB, float radB) {
+	posAX.emplace_back(posA.x); posAY.emplace_back(posA.y); posAZ.emplace_back(posA.z); radiusA.emplace_back(radA);
+	posBX.emplace_back(posB.x); posBY.emplace_back(posB.y); posBZ.emplace_back(posB.z); radiusB.emplace_back(radB);
+}
+
+void SphereSphereBatch::Run() {
+	size_t count = Size();
+	hit.resize(count);
+	normalX.resize(count); normalY.resize(count); normalZ.resize(count);
+	penetration.resize(count);
+
+	size_t done = BatchCollision::UsingAVX2() ? BatchCollision::SphereSphereAVX2(*this) : 0;
+	BatchCollision::SphereSphereScalar(*this, done, count);
+}
+
+void AABBSphereBatch::Clear() {
+	boxX.clear(); boxY.clear(); boxZ.clear(); halfX.clear(); halfY.clear(); halfZ.clear();
+	sphereX.clear(); sphereY.clear(); sphereZ.clear(); radius.clear();
+}
+
+void AABBSphereBatch::Add(const Vector3& boxPos, const Vector3& halfSize, const Vector3& spherePos, float sphereRadius) {
+	boxX.emplace_back(boxPos.x); boxY.emplace_back(boxPos.y); boxZ.emplace_back(boxPos.z);
+	halfX.emplace_back(halfSize.x); halfY.emplace_back(halfSize.y); halfZ.emplace_back(halfSize.z);
+	sphereX.emplace_back(spherePos.x); sphereY.emplace_back(spherePos.y); sphereZ.emplace_back(spherePos.z);
+	radius.emplace_back(sphereRadius);
+}
+
+void AABBSphereBatch::Run() {
+	size_t count = Size();
+	hit.resize(count);
+	normalX.resize(count); normalY.resize(count); normalZ.resize(count);
+	penetration.resize(count);
+
+	size_t done = BatchCollision::UsingAVX2() ? BatchCollision::AABBSphereAVX2(*this) : 0;
+	BatchCollision::AABBSphereScalar(*this, done, count);
+}
+
+/*
+AVX2 needs the OS to save the bigger registers on a context switch as well as the CPU
+supporting it, so OSXSAVE and XCR0 get checked as well as the AVX2 feature bit.
+*/
+bool BatchCollision::CPUHasAVX2() {
+#if defined(BATCH_COLLISION_AVX2) && defined(_MSC_VER)
+	static bool hasAVX2 = []() {
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		bool osxsave	= (info[2] & (1 << 27)) != 0;
+		bool avx		= (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+	}();
+	return hasAVX2;
+#elif defined(BATCH_COLLISION_AVX2)
+	static bool hasAVX2 = __builtin_cpu_supports("avx2") != 0;
+	return hasAVX2;
+#else
+	return false;
+#endif
+}
+
+// the same maths as SphereIntersection, including only normalising non zero deltas
+void BatchCollision::SphereSphereScalar(SphereSphereBatch& b, size_t first, size_t last) {
+	for (size_t i = first; i < last; ++i) {
+		float radii	= b.radiusA[i] + b.radiusB[i];
+		float dx	= b.posBX[i] - b.posAX[i];
+		float dy	= b.posBY[i] - b.posAY[i];
+		float dz	= b.posBZ[i] - b.posAZ[i];
+		float length = sqrt((dx * dx) + (dy * dy) + (dz * dz));
+
+		b.hit[i] = length < radii;
+		float inv = length != 0.0f ? 1.0f / length : 1.0f;
+		b.normalX[i]		= dx * inv;
+		b.normalY[i]		= dy * inv;
+		b.normalZ[i]		= dz * inv;
+		b.penetration[i]	= radii - length;
+	}
+}
+
+// the same maths as AABBSphereIntersection
+void BatchCollision::AABBSphereScalar(AABBSphereBatch& b, size_t first, size_t last) {
+	for (size_t i = first; i < last; ++i) {
+		float dx = b.sphereX[i] - b.boxX[i];
+		float dy = b.sphereY[i] - b.boxY[i];
+		float dz = b.sphereZ[i] - b.boxZ[i];
+
+		float lx = dx - std::min(std::max(dx, -b.halfX[i]), b.halfX[i]);
+		float ly = dy - std::min(std::max(dy, -b.halfY[i]), b.halfY[i]);
+		float lz = dz - std::min(std::max(dz, -b.halfZ[i]), b.halfZ[i]);
+		float distance = sqrt((lx * lx) + (ly * ly) + (lz * lz));
+
+		b.hit[i] = distance < b.radius[i];
+		float inv = distance != 0.0f ? 1.0f / distance : 1.0f;
+		b.normalX[i]		= lx * inv;
+		b.normalY[i]		= ly * inv;
+		b.normalZ[i]		= lz * inv;
+		b.penetration[i]	= b.radius[i] - distance;
+	}
+}
+
+#ifdef BATCH_COLLISION_AVX2
+namespace {
+	// 1 / length, or 1 where the length is 0 so the zero vector is left alone
+	AVX2_FUNCTION inline __m256 SafeReciprocal(__m256 length) {
+		__m256 zero		= _mm256_setzero_ps();
+		__m256 one		= _mm256_set1_ps(1.0f);
+		__m256 isZero	= _mm256_cmp_ps(length, zero, _CMP_EQ_OQ);
+		return _mm256_blendv_ps(_mm256_div_ps(one, length), one, isZero);
+	}
+
+	AVX2_FUNCTION inline void StoreHits(unsigned char* hit, __m256 mask) {
+		int bits = _mm256_movemask_ps(mask);
+		for (int j = 0; j < 8; ++j)
+			hit[j] = (bits >> j) & 1;
+	}
+}
+
+/*
+No FMA here on purpose - fused multiply adds round differently, and the results
+should match the scalar path exactly whichever one the CPU ends up using.
+*/
+AVX2_FUNCTION size_t BatchCollision::SphereSphereAVX2(SphereSphereBatch& b) {
+	size_t count = b.Size() & ~(size_t)7;
+	for (size_t i = 0; i < count; i += 8) {
+		__m256 radii	= _mm256_add_ps(_mm256_loadu_ps(&b.radiusA[i]), _mm256_loadu_ps(&b.radiusB[i]));
+		__m256 dx		= _mm256_sub_ps(_mm256_loadu_ps(&b.posBX[i]), _mm256_loadu_ps(&b.posAX[i]));
+		__m256 dy		= _mm256_sub_ps(_mm256_loadu_ps(&b.posBY[i]), _mm256_loadu_ps(&b.posAY[i]));
+		__m256 dz		= _mm256_sub_ps(_mm256_loadu_ps(&b.posBZ[i]), _mm256_loadu_ps(&b.posAZ[i]));
+
+		__m256 lengthSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+		__m256 length	= _mm256_sqrt_ps(lengthSq);
+		__m256 inv		= SafeReciprocal(length);
+
+		StoreHits(&b.hit[i], _mm256_cmp_ps(length, radii, _CMP_LT_OQ));
+		_mm256_storeu_ps(&b.normalX[i], _mm256_mul_ps(dx, inv));
+		_mm256_storeu_ps(&b.normalY[i], _mm256_mul_ps(dy, inv));
+		_mm256_storeu_ps(&b.normalZ[i], _mm256_mul_ps(dz, inv));
+		_mm256_storeu_ps(&b.penetration[i], _mm256_sub_ps(radii, length));
+	}
+	return count;
+}
+
+AVX2_FUNCTION size_t BatchCollision::AABBSphereAVX2(AABBSphereBatch& b) {
+	size_t count = b.Size() & ~(size_t)7;
+	__m256 signBit = _mm256_set1_ps(-0.0f);
+	for (size_t i = 0; i < count; i += 8) {
+		__m256 hx = _mm256_loadu_ps(&b.halfX[i]);
+		__m256 hy = _mm256_loadu_ps(&b.halfY[i]);
+		__m256 hz = _mm256_loadu_ps(&b.halfZ[i]);
+
+		__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&b.sphereX[i]), _mm256_loadu_ps(&b.boxX[i]));
+		__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&b.sphereY[i]), _mm256_loadu_ps(&b.boxY[i]));
+		__m256 dz = _mm256_sub_ps(_mm256_loadu_ps(&b.sphereZ[i]), _mm256_loadu_ps(&b.boxZ[i]));
+
+		// clamp to the box, then take that off to leave the offset from the closest point
+		__m256 lx = _mm256_sub_ps(dx, _mm256_min_ps(_mm256_max_ps(dx, _mm256_xor_ps(hx, signBit)), hx));
+		__m256 ly = _mm256_sub_ps(dy, _mm256_min_ps(_mm256_max_ps(dy, _mm256_xor_ps(hy, signBit)), hy));
+		__m256 lz = _mm256_sub_ps(dz, _mm256_min_ps(_mm256_max_ps(dz, _mm256_xor_ps(hz, signBit)), hz));
+
+		__m256 distanceSq	= _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lx, lx), _mm256_mul_ps(ly, ly)), _mm256_mul_ps(lz, lz));
+		__m256 distance		= _mm256_sqrt_ps(distanceSq);
+		__m256 inv			= SafeReciprocal(distance);
+		__m256 rad			= _mm256_loadu_ps(&b.radius[i]);
+
+		StoreHits(&b.hit[i], _mm256_cmp_ps(distance, rad, _CMP_LT_OQ));
+		_mm256_storeu_ps(&b.normalX[i], _mm256_mul_ps(lx, inv));
+		_mm256_storeu_ps(&b.normalY[i], _mm256_mul_ps(ly, inv));
+		_mm256_storeu_ps(&b.normalZ[i], _mm256_mul_ps(lz, inv));
+		_mm256_storeu_ps(&b.penetration[i], _mm256_sub_ps(rad, distance));
+	}
+	return count;
+}
+#else
+size_t BatchCollision::SphereSphereAVX2(SphereSphereBatch& b) {
+	return 0;
+}
+
+size_t BatchCollision::AABBSphereAVX2(AABBSphereBatch& b) {
+	return 0;
+}
+#endif
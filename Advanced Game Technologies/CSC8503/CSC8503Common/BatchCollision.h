@@ -0,0 +1,88 @@
+#pragma once
+#include "../../Common/Vector3.h"
+#include <vector>
+#include <cstddef>
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		/*
+		Pair tests done a whole bucket at a time, rather than one pair at a time through the
+		volumes and transforms. The inputs are stored as structures of arrays, so 8 pairs can
+		be loaded and tested at once using AVX2, if the CPU has it - otherwise the same maths
+		is done one pair at a time. Both paths give exactly the same results as
+		CollisionDetection::SphereIntersection / AABBSphereIntersection.
+
+		After Run, hit[i] is set for each pair that's touching, and normal / penetration are
+		filled in for those pairs (they're left as garbage for the ones that aren't).
+		*/
+		struct SphereSphereBatch {
+			std::vector<float> posAX, posAY, posAZ, radiusA;
+			std::vector<float> posBX, posBY, posBZ, radiusB;
+
+			std::vector<unsigned char>	hit;
+			std::vector<float>			normalX, normalY, normalZ, penetration;
+
+			void Clear();
+			void Add(const Vector3& posA, float radA, const Vector3& posB, float radB);
+			void Run();
+
+			size_t Size() const {
+				return radiusA.size();
+			}
+
+			Vector3 GetNormal(size_t i) const {
+				return Vector3(normalX[i], normalY[i], normalZ[i]);
+			}
+		};
+
+		// the AABB is always object a, as in AABBSphereIntersection
+		struct AABBSphereBatch {
+			std::vector<float> boxX, boxY, boxZ, halfX, halfY, halfZ;
+			std::vector<float> sphereX, sphereY, sphereZ, radius;
+
+			std::vector<unsigned char>	hit;
+			std::vector<float>			normalX, normalY, normalZ, penetration;
+
+			void Clear();
+			void Add(const Vector3& boxPos, const Vector3& halfSize, const Vector3& spherePos, float sphereRadius);
+			void Run();
+
+			size_t Size() const {
+				return radius.size();
+			}
+
+			Vector3 GetNormal(size_t i) const {
+				return Vector3(normalX[i], normalY[i], normalZ[i]);
+			}
+		};
+
+		class BatchCollision {
+		public:
+			// checked once, the first time it's asked for
+			static bool CPUHasAVX2();
+
+			// lets the scalar path be forced on, for comparing the two
+			static void UseAVX2(bool state) {
+				GetUseAVX2() = state;
+			}
+
+			static bool UsingAVX2() {
+				return GetUseAVX2() && CPUHasAVX2();
+			}
+
+			static void SphereSphereScalar(SphereSphereBatch& b, size_t first, size_t last);
+			static void AABBSphereScalar(AABBSphereBatch& b, size_t first, size_t last);
+
+			// return how many pairs were done - any left over (less than 8) need doing with the scalar version
+			static size_t SphereSphereAVX2(SphereSphereBatch& b);
+			static size_t AABBSphereAVX2(AABBSphereBatch& b);
+
+		protected:
+			static bool& GetUseAVX2() {
+				static bool useAVX2 = true;
+				return useAVX2;
+			}
+		};
+	}
+}
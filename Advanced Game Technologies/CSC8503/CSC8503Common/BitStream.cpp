@@ -0,0 +1,104 @@
+#include "BitStream.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+QuantisedFloat QuantisedFloat::WithPrecision(float range, float precision) {
+	// each step covers precision, so no value's more than half of one away
+	uint32_t steps	= (uint32_t)std::ceil(range / precision);
+	int bits		= 2;
+	while (bits < 31 && (uint32_t)((1 << (bits - 1)) - 1) < steps) {
+		++bits;
+	}
+	return QuantisedFloat(range, bits);
+}
+
+bool QuantisedFloat::Quantise(float value, uint32_t& q) const {
+	if (!(std::fabs(value) <= range)) {
+		return false;
+	}
+	int steps	= Steps();
+	int i		= (int)std::lround(value / range * steps);
+	q = (uint32_t)(std::min(std::max(i, -steps), steps) + steps);
+	return true;
+}
+
+float QuantisedFloat::Dequantise(uint32_t q) const {
+	int steps = Steps();
+	return ((int)q - steps) * (range / steps);
+}
+
+BitWriter::BitWriter(char* data, int capacity) : data(data), capacity(capacity) {
+}
+
+bool BitWriter::Write(uint32_t value, int bits) {
+	if (overflowed || bitsWritten + bits > capacity * 8) {
+		overflowed = true;
+		return false;
+	}
+	for (int done = 0; done < bits; ) {
+		int byte	= bitsWritten >> 3;
+		int offset	= bitsWritten & 7;
+		int count	= std::min(8 - offset, bits - done);
+		uint32_t chunk = (value >> done) & ((1u << count) - 1);
+
+		if (offset == 0) {
+			data[byte] = 0;	// so the buffer doesn't need clearing first
+		}
+		data[byte] |= (char)(chunk << offset);
+
+		bitsWritten += count;
+		done		+= count;
+	}
+	return true;
+}
+
+bool BitWriter::WriteQuantised(float value, const QuantisedFloat& q) {
+	uint32_t i;
+	if (!q.Quantise(value, i)) {
+		return false;
+	}
+	return Write(i, q.bits);
+}
+
+BitReader::BitReader(const char* data, int size) : data(data), size(size) {
+}
+
+bool BitReader::Read(uint32_t& value, int bits) {
+	if (overflowed || bitsRead + bits > size * 8) {
+		overflowed = true;
+		return false;
+	}
+	value = 0;
+	for (int done = 0; done < bits; ) {
+		int byte	= bitsRead >> 3;
+		int offset	= bitsRead & 7;
+		int count	= std::min(8 - offset, bits - done);
+		uint32_t chunk = ((uint8_t)data[byte] >> offset) & ((1u << count) - 1);
+
+		value		|= chunk << done;
+		bitsRead	+= count;
+		done		+= count;
+	}
+	return true;
+}
+
+bool BitReader::ReadBool(bool& value) {
+	uint32_t i;
+	if (!Read(i, 1)) {
+		return false;
+	}
+	value = i != 0;
+	return true;
+}
+
+bool BitReader::ReadQuantised(float& value, const QuantisedFloat& q) {
+	uint32_t i;
+	if (!Read(i, q.bits)) {
+		return false;
+	}
+	value = q.Dequantise(i);
+	return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A float squeezed into a given number of bits, for values known to be within
+		-range...range. The steps are spread evenly either side of 0, so 0 always comes
+		back as exactly 0, and a value is never more than Precision() / 2 out.
+		*/
+		struct QuantisedFloat {
+			float	range	= 1.0f;
+			int		bits	= 8;	// 2 to 31
+
+			QuantisedFloat() {
+			}
+
+			QuantisedFloat(float range, int bits) : range(range), bits(bits) {
+			}
+
+			// as few bits as will get within precision / 2 of any value in -range...range
+			static QuantisedFloat WithPrecision(float range, float precision);
+
+			int Steps() const {
+				return (1 << (bits - 1)) - 1;	// each side of 0
+			}
+
+			float Precision() const {
+				return range / Steps();
+			}
+
+			// false if value is out of range (or not a number)
+			bool Quantise(float value, uint32_t& q) const;
+			float Dequantise(uint32_t q) const;
+		};
+
+		/*
+		Writes values into a fixed size buffer using only as many bits as they need,
+		least significant bit first. Once something won't fit, the writer's marked as
+		overflowed and ignores everything else.
+		*/
+		class BitWriter {
+		public:
+			BitWriter(char* data, int capacity);
+
+			bool Write(uint32_t value, int bits);
+			bool WriteBool(bool value) {
+				return Write(value ? 1 : 0, 1);
+			}
+			// false, and nothing written, if value is out of q's range
+			bool WriteQuantised(float value, const QuantisedFloat& q);
+
+			int GetBitsWritten() const {
+				return bitsWritten;
+			}
+
+			int GetBytesWritten() const {
+				return (bitsWritten + 7) / 8;
+			}
+
+			bool HasOverflowed() const {
+				return overflowed;
+			}
+
+		protected:
+			char*	data;
+			int		capacity;	// in bytes
+			int		bitsWritten	= 0;
+			bool	overflowed	= false;
+		};
+
+		// reads back what a BitWriter wrote, failing rather than reading past the end
+		class BitReader {
+		public:
+			BitReader(const char* data, int size);
+
+			bool Read(uint32_t& value, int bits);
+			bool ReadBool(bool& value);
+			bool ReadQuantised(float& value, const QuantisedFloat& q);
+
+			bool HasOverflowed() const {
+				return overflowed;
+			}
+
+		protected:
+			const char*	data;
+			int			size;	// in bytes
+			int			bitsRead	= 0;
+			bool		overflowed	= false;
+		};
+	}
+}
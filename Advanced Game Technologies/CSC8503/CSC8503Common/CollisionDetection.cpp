@@ -1,4 +1,5 @@
 #include "CollisionDetection.h"
+#include "CollisionDispatch.h"
 #include "CollisionVolume.h"
 #include "AABBVolume.h"
 #include "OBBVolume.h"
@@ -82,11 +83,11 @@ bool CollisionDetection::RayAABBIntersection(const Ray&r, const Transform& world
 }
 
 bool CollisionDetection::RayOBBIntersection(const Ray&r, const Transform& worldTransform, const OBBVolume& volume, RayCollision& collision) {
-	Quaternion orientation = worldTransform.GetWorldOrientation();
 	Vector3 position = worldTransform.GetWorldPosition();
 
-	Matrix3 transform = Matrix3(orientation);
-	Matrix3 invTransform = Matrix3(orientation.Conjugate());
+	// a rotation's inverse is its transpose
+	Matrix3 transform		= Matrix3(worldTransform.GetWorldOrientation());
+	Matrix3 invTransform	= transform.Transposed();
 
 	Vector3 localRayPos = r.GetPosition() - position;
 
@@ -130,43 +131,57 @@ bool CollisionDetection::RaySphereIntersection(const Ray&r, const Transform& wor
 }
 
 bool CollisionDetection::ObjectIntersection(GameObject* a, GameObject* b, CollisionInfo& collisionInfo) {
+	return VolumeIntersection(a, a->GetBoundingVolume(), b, b->GetBoundingVolume(), collisionInfo);
+}
+
+/*
+Speculative contacts are found by growing object a's volume by the margin and running the
+normal tests - anything hit within the margin gives us a contact normal, and taking the
+margin back off the penetration leaves the size of the gap still to close.
+*/
+bool CollisionDetection::SpeculativeIntersection(GameObject* a, GameObject* b, float margin, CollisionInfo& collisionInfo) {
 	const CollisionVolume* volA = a->GetBoundingVolume();
-	const CollisionVolume* volB = b->GetBoundingVolume();
+	if (!volA || margin <= 0.0f)
+		return false;
+
+	Vector3 grow = Vector3(margin, margin, margin);
+	AABBVolume		grownAABB(Vector3(0, 0, 0));
+	OBBVolume		grownOBB(Vector3(0, 0, 0));
+	SphereVolume	grownSphere;
+
+	switch (volA->type) {
+	case VolumeType::AABB:
+		grownAABB = AABBVolume(((AABBVolume&)*volA).GetHalfDimensions() + grow);
+		volA = (CollisionVolume*)&grownAABB; break;
+	case VolumeType::OBB:
+		grownOBB = OBBVolume(((OBBVolume&)*volA).GetHalfDimensions() + grow);
+		volA = (CollisionVolume*)&grownOBB; break;
+	case VolumeType::Sphere:
+		grownSphere = SphereVolume(((SphereVolume&)*volA).GetRadius() + margin);
+		volA = (CollisionVolume*)&grownSphere; break;
+	default:
+		return false;
+	}
+
+	if (!VolumeIntersection(a, volA, b, b->GetBoundingVolume(), collisionInfo))
+		return false;
+
+	collisionInfo.point.penetration = min(collisionInfo.point.penetration - margin, 0.0f);
+	return true;
+}
 
+bool CollisionDetection::VolumeIntersection(GameObject* a, const CollisionVolume* volA, GameObject* b, const CollisionVolume* volB,
+	CollisionInfo& collisionInfo) {
 	if (!volA || !volB)
 		return false;
 
 	collisionInfo.a = a;
 	collisionInfo.b = b;
 
-	const Transform& transformA = a->GetConstTransform();
-	const Transform& transformB = b->GetConstTransform();
-
-	VolumeType pairType = (VolumeType)((int)volA->type | (int)volB->type);
-
-	if (pairType == VolumeType::AABB)
-		return AABBIntersection((AABBVolume&)*volA, transformA, (AABBVolume&)*volB, transformB, collisionInfo);
-	if (pairType == VolumeType::Sphere)
-		return SphereIntersection((SphereVolume&)*volA, transformA, (SphereVolume&)*volB, transformB, collisionInfo);
-	if (volA->type == VolumeType::AABB && volB->type == VolumeType::Sphere)
-		return AABBSphereIntersection((AABBVolume&)*volA, transformA, (SphereVolume&)*volB, transformB, collisionInfo);
-	if (volA->type == VolumeType::Sphere && volB->type == VolumeType::AABB) {
-		// AABBSphereIntersection expects the AABB volume first so rearrange collisionInfo data
-		collisionInfo.a = b;
-		collisionInfo.b = a;
-		return AABBSphereIntersection((AABBVolume&)*volB, transformB, (SphereVolume&)*volA, transformA, collisionInfo);
-	}
-	// @TODO just for now so OBBs at least collide with ABBs until OBBABB is implemented
-	if ((volA->type == VolumeType::OBB && volB->type == VolumeType::AABB) || (volB->type == VolumeType::OBB && volA->type == VolumeType::AABB))
-		return AABBIntersection((AABBVolume&)*volA, transformA, (AABBVolume&)*volB, transformB, collisionInfo);
-	if (volA->type == VolumeType::OBB && volB->type == VolumeType::Sphere)
-		return OBBSphereIntersection((OBBVolume&)*volA, transformA, (SphereVolume&)*volB, transformB, collisionInfo);
-	if (volA->type == VolumeType::Sphere && volB->type == VolumeType::OBB) {
-		collisionInfo.a = b;
-		collisionInfo.b = a;
-		return OBBSphereIntersection((OBBVolume&)*volB, transformB, (SphereVolume&)*volA, transformA, collisionInfo);
-	}
-	return false;
+	// one lookup and one call, rather than working through a chain of type checks. reversed pairs
+	// (like Sphere / AABB) swap collisionInfo's objects themselves - see CollisionDispatch.h
+	return volumePairTable[VolumePairIndex(volA->type, volB->type)](*volA, a->GetConstPhysicsTransform(),
+		*volB, b->GetConstPhysicsTransform(), collisionInfo);
 }
 
 bool CollisionDetection::AABBTest(const Vector3& posA, const Vector3& posB, const Vector3& halfSizeA, const Vector3& halfSizeB) {
@@ -291,11 +306,10 @@ bool CollisionDetection::OBBSphereIntersection(const OBBVolume& volumeA, const T
 	const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
 
 	// obb orientation
-	Quaternion orientation = worldTransformA.GetWorldOrientation();
 	Vector3 position = worldTransformA.GetWorldPosition();
 
-	Matrix3 transform = Matrix3(orientation);
-	Matrix3 invTransform = Matrix3(orientation.Conjugate());
+	Matrix3 transform		= Matrix3(worldTransformA.GetWorldOrientation());
+	Matrix3 invTransform	= transform.Transposed();
 
 	Vector3 boxSize = volumeA.GetHalfDimensions();
 	Vector3 delta = worldTransformB.GetWorldPosition() - worldTransformA.GetWorldPosition();
@@ -384,13 +398,6 @@ Vector3 CollisionDetection::Unproject(const Vector3& screenPos, const Camera& ca
 	//the order of matrices used to form it are inverted, too.
 	Matrix4 invVP = GenerateInverseView(cam) * GenerateInverseProjection(aspect, fov, nearPlane, farPlane);
 
-	Matrix4 test1 = GenerateInverseView(cam);
-	Matrix4 test2 = cam.BuildViewMatrix().Inverse();
-
-	Matrix4 proj  = cam.BuildProjectionMatrix(aspect);
-	Matrix4 test4 = cam.BuildProjectionMatrix(aspect).Inverse();
-	Matrix4 test3 = GenerateInverseProjection(aspect, fov, nearPlane, farPlane);
-
 	//Our mouse position x and y values are in 0 to screen dimensions range,
 	//so we need to turn them into the -1 to 1 axis range of clip space.
 	//We can do that by dividing the mouse values by the width and height of the
@@ -71,6 +71,10 @@ namespace NCL {
 
 		static bool ObjectIntersection(GameObject* a, GameObject* b, CollisionInfo& collisionInfo);
 
+		// for objects that aren't touching, but are closer than the margin. the contact's penetration
+		// is negative, and its magnitude is the gap between the two objects along the normal
+		static bool SpeculativeIntersection(GameObject* a, GameObject* b, float margin, CollisionInfo& collisionInfo);
+
 
 		static bool AABBIntersection(const AABBVolume& volumeA, const Transform& worldTransformA,
 			const AABBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
@@ -98,8 +102,8 @@ namespace NCL {
 		static Matrix4		GenerateInverseView(const Camera& c);
 
 	protected:
-
-
+		static bool VolumeIntersection(GameObject* a, const CollisionVolume* volA, GameObject* b, const CollisionVolume* volB,
+			CollisionInfo& collisionInfo);
 
 	private:
 		CollisionDetection() {}
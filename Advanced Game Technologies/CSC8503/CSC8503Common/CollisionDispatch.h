@@ -0,0 +1,151 @@
+#pragma once
+#include "CollisionDetection.h"
+#include <array>
+#include <utility>
+#include <type_traits>
+
+namespace NCL {
+	namespace CSC8503 {
+		typedef bool(*VolumePairFunc)(const CollisionVolume& volA, const Transform& transformA,
+			const CollisionVolume& volB, const Transform& transformB, CollisionDetection::CollisionInfo& collisionInfo);
+
+		// every volume type the dispatch table knows about. anything else gets the last row / column, which never collides
+		constexpr VolumeType dispatchVolumeTypes[] = {
+			VolumeType::AABB,
+			VolumeType::OBB,
+			VolumeType::Sphere,
+			VolumeType::Mesh,
+			VolumeType::Compound
+		};
+		constexpr int numDispatchVolumeTypes	= sizeof(dispatchVolumeTypes) / sizeof(VolumeType);
+		constexpr int dispatchTableWidth		= numDispatchVolumeTypes + 1;
+		constexpr int maxVolumeTypeValue		= (int)VolumeType::Invalid;
+
+		constexpr int DispatchIndex(VolumeType type) {
+			for (int i = 0; i < numDispatchVolumeTypes; ++i) {
+				if (dispatchVolumeTypes[i] == type)
+					return i;
+			}
+			return numDispatchVolumeTypes;
+		}
+
+		constexpr VolumeType DispatchVolumeType(int index) {
+			return index < numDispatchVolumeTypes ? dispatchVolumeTypes[index] : VolumeType::Invalid;
+		}
+
+		/*
+		One of these for each pair of volumes we can test. Only one ordering of a pair needs
+		writing, PairDispatch works out the other one. To add a new volume type, add it to
+		dispatchVolumeTypes above and specialise PairKernel for each pair it should collide with.
+		*/
+		template<VolumeType A, VolumeType B>
+		struct PairKernel {
+			static constexpr bool implemented = false;
+
+			static bool Test(const CollisionVolume&, const Transform&, const CollisionVolume&, const Transform&, CollisionDetection::CollisionInfo&) {
+				return false;
+			}
+		};
+
+		template<>
+		struct PairKernel<VolumeType::AABB, VolumeType::AABB> {
+			static constexpr bool implemented = true;
+
+			static bool Test(const CollisionVolume& volA, const Transform& transformA,
+				const CollisionVolume& volB, const Transform& transformB, CollisionDetection::CollisionInfo& collisionInfo) {
+				return CollisionDetection::AABBIntersection((const AABBVolume&)volA, transformA, (const AABBVolume&)volB, transformB, collisionInfo);
+			}
+		};
+
+		template<>
+		struct PairKernel<VolumeType::Sphere, VolumeType::Sphere> {
+			static constexpr bool implemented = true;
+
+			static bool Test(const CollisionVolume& volA, const Transform& transformA,
+				const CollisionVolume& volB, const Transform& transformB, CollisionDetection::CollisionInfo& collisionInfo) {
+				return CollisionDetection::SphereIntersection((const SphereVolume&)volA, transformA, (const SphereVolume&)volB, transformB, collisionInfo);
+			}
+		};
+
+		template<>
+		struct PairKernel<VolumeType::AABB, VolumeType::Sphere> {
+			static constexpr bool implemented = true;
+
+			static bool Test(const CollisionVolume& volA, const Transform& transformA,
+				const CollisionVolume& volB, const Transform& transformB, CollisionDetection::CollisionInfo& collisionInfo) {
+				return CollisionDetection::AABBSphereIntersection((const AABBVolume&)volA, transformA, (const SphereVolume&)volB, transformB, collisionInfo);
+			}
+		};
+
+		template<>
+		struct PairKernel<VolumeType::OBB, VolumeType::Sphere> {
+			static constexpr bool implemented = true;
+
+			static bool Test(const CollisionVolume& volA, const Transform& transformA,
+				const CollisionVolume& volB, const Transform& transformB, CollisionDetection::CollisionInfo& collisionInfo) {
+				return CollisionDetection::OBBSphereIntersection((const OBBVolume&)volA, transformA, (const SphereVolume&)volB, transformB, collisionInfo);
+			}
+		};
+
+		// @TODO just for now so OBBs at least collide with ABBs until OBBABB is implemented
+		template<>
+		struct PairKernel<VolumeType::OBB, VolumeType::AABB> {
+			static constexpr bool implemented = true;
+
+			static bool Test(const CollisionVolume& volA, const Transform& transformA,
+				const CollisionVolume& volB, const Transform& transformB, CollisionDetection::CollisionInfo& collisionInfo) {
+				return CollisionDetection::AABBIntersection((const AABBVolume&)volA, transformA, (const AABBVolume&)volB, transformB, collisionInfo);
+			}
+		};
+
+		/*
+		Picks between PairKernel<A, B> and PairKernel<B, A> at compile time. If only the
+		reversed kernel exists, the volumes are passed over the other way round, and the
+		objects in collisionInfo are swapped to match - so there's no runtime check for it.
+		*/
+		template<VolumeType A, VolumeType B>
+		struct PairDispatch {
+			static bool Test(const CollisionVolume& volA, const Transform& transformA,
+				const CollisionVolume& volB, const Transform& transformB, CollisionDetection::CollisionInfo& collisionInfo) {
+				typedef std::integral_constant<bool, PairKernel<A, B>::implemented || !PairKernel<B, A>::implemented> InOrder;
+				return Select(InOrder(), volA, transformA, volB, transformB, collisionInfo);
+			}
+
+		protected:
+			static bool Select(std::true_type, const CollisionVolume& volA, const Transform& transformA,
+				const CollisionVolume& volB, const Transform& transformB, CollisionDetection::CollisionInfo& collisionInfo) {
+				return PairKernel<A, B>::Test(volA, transformA, volB, transformB, collisionInfo);
+			}
+
+			static bool Select(std::false_type, const CollisionVolume& volA, const Transform& transformA,
+				const CollisionVolume& volB, const Transform& transformB, CollisionDetection::CollisionInfo& collisionInfo) {
+				std::swap(collisionInfo.a, collisionInfo.b);
+				return PairKernel<B, A>::Test(volB, transformB, volA, transformA, collisionInfo);
+			}
+		};
+
+		template<size_t... I>
+		constexpr std::array<VolumePairFunc, sizeof...(I)> MakeVolumePairTable(std::index_sequence<I...>) {
+			return {{ &PairDispatch<DispatchVolumeType(I / dispatchTableWidth), DispatchVolumeType(I % dispatchTableWidth)>::Test... }};
+		}
+
+		template<size_t... I>
+		constexpr std::array<unsigned char, sizeof...(I)> MakeDispatchIndexTable(std::index_sequence<I...>) {
+			return {{ (unsigned char)DispatchIndex((VolumeType)I)... }};
+		}
+
+		// the table itself, dispatchTableWidth * dispatchTableWidth entries, indexed by [typeA][typeB]
+		constexpr std::array<VolumePairFunc, dispatchTableWidth * dispatchTableWidth> volumePairTable =
+			MakeVolumePairTable(std::make_index_sequence<dispatchTableWidth * dispatchTableWidth>());
+
+		// turns the VolumeType flag values into table indices without a search
+		constexpr std::array<unsigned char, maxVolumeTypeValue + 1> dispatchIndexTable =
+			MakeDispatchIndexTable(std::make_index_sequence<maxVolumeTypeValue + 1>());
+
+		inline int VolumePairIndex(VolumeType a, VolumeType b) {
+			int indexA = (unsigned int)a <= (unsigned int)maxVolumeTypeValue ? dispatchIndexTable[(int)a] : numDispatchVolumeTypes;
+			int indexB = (unsigned int)b <= (unsigned int)maxVolumeTypeValue ? dispatchIndexTable[(int)b] : numDispatchVolumeTypes;
+			return indexA * dispatchTableWidth + indexB;
+		}
+	}
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include "ComponentPool.h"
+
 namespace NCL {
 	enum class VolumeType {
 		AABB	= 1,
@@ -14,7 +16,7 @@ namespace NCL {
 		CollisionVolume() {
 			type = VolumeType::Invalid;
 		}
-		~CollisionVolume() {}
+		virtual ~CollisionVolume() {}
 
 		VolumeType type;
 	};
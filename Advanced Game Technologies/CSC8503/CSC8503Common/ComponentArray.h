@@ -0,0 +1,134 @@
+#pragma once
+#include <vector>
+#include <utility>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Every shared ComponentArray registers itself here, so when an entity is destroyed
+		its components can be removed from every array without knowing what types exist.
+		*/
+		class ComponentArrayBase {
+		public:
+			virtual ~ComponentArrayBase() {}
+
+			virtual void Remove(unsigned int entity) = 0;
+
+			static void RemoveFromShared(unsigned int entity) {
+				for (ComponentArrayBase* a : GetSharedArrays()) {
+					a->Remove(entity);
+				}
+			}
+
+		protected:
+			static std::vector<ComponentArrayBase*>& GetSharedArrays() {
+				static std::vector<ComponentArrayBase*> arrays;
+				return arrays;
+			}
+		};
+
+		/*
+		Stores one type of component for any number of entities, packed together so a
+		system can loop over just the components it cares about without touching the
+		objects that own them. Removing fills the gap with the last component, so the
+		order changes - use GetEntity(i) to find out who component i belongs to.
+
+		Shared() is the array GameObject::AddComponent and friends use. Other arrays
+		(a GameWorld's list of render objects, say) are just made as normal members.
+		*/
+		template<class T>
+		class ComponentArray : public ComponentArrayBase {
+		public:
+			ComponentArray() {}
+
+			static ComponentArray& Shared() {
+				static ComponentArray shared(true);
+				return shared;
+			}
+
+			T& Add(unsigned int entity, const T& component = T()) {
+				if (entity >= lookup.size()) {
+					lookup.resize(entity + 1, -1);
+				}
+				if (lookup[entity] >= 0) {
+					components[lookup[entity]] = component;
+					return components[lookup[entity]];
+				}
+				lookup[entity] = (int)components.size();
+				components.emplace_back(component);
+				entities.emplace_back(entity);
+				return components.back();
+			}
+
+			void Remove(unsigned int entity) override {
+				if (!Has(entity)) {
+					return;
+				}
+				int index		= lookup[entity];
+				int lastIndex	= (int)components.size() - 1;
+				if (index != lastIndex) {
+					components[index]	= std::move(components[lastIndex]);
+					entities[index]		= entities[lastIndex];
+					lookup[entities[index]] = index;
+				}
+				components.pop_back();
+				entities.pop_back();
+				lookup[entity] = -1;
+			}
+
+			bool Has(unsigned int entity) const {
+				return entity < lookup.size() && lookup[entity] >= 0;
+			}
+
+			T* Get(unsigned int entity) {
+				return Has(entity) ? &components[lookup[entity]] : nullptr;
+			}
+
+			const T* Get(unsigned int entity) const {
+				return Has(entity) ? &components[lookup[entity]] : nullptr;
+			}
+
+			void Clear() {
+				components.clear();
+				entities.clear();
+				lookup.clear();
+			}
+
+			size_t Size() const {
+				return components.size();
+			}
+
+			T& operator[](size_t i) {
+				return components[i];
+			}
+
+			const T& operator[](size_t i) const {
+				return components[i];
+			}
+
+			unsigned int GetEntity(size_t i) const {
+				return entities[i];
+			}
+
+			const T* Data() const {
+				return components.data();
+			}
+
+			typename std::vector<T>::iterator begin()				{ return components.begin(); }
+			typename std::vector<T>::iterator end()					{ return components.end(); }
+			typename std::vector<T>::const_iterator begin() const	{ return components.begin(); }
+			typename std::vector<T>::const_iterator end() const		{ return components.end(); }
+
+		protected:
+			ComponentArray(bool shared) {
+				if (shared) {
+					GetSharedArrays().emplace_back(this);
+				}
+			}
+
+			std::vector<T>				components;
+			std::vector<unsigned int>	entities;	// which entity each component belongs to
+			std::vector<int>			lookup;		// entity -> index into components, -1 if it hasn't got one
+		};
+	}
+}
@@ -0,0 +1,187 @@
+#pragma once
+#include <vector>
+#include <new>
+#include <typeinfo>
+#include <cstddef>
+
+namespace NCL {
+	namespace CSC8503 {
+		struct ComponentPoolStats {
+			const char* name;
+			size_t liveCount;			// blocks currently handed out
+			size_t peakCount;			// most blocks ever handed out at once
+			size_t totalAllocations;	// allocations since the pool was created
+			size_t fallbackAllocations;	// allocations too big for the pool (subclasses), sent to the heap
+			size_t slabCount;
+			size_t capacity;			// blocks across every slab
+		};
+
+		/*
+		Every ComponentPool registers itself here, so the game can print stats for, or
+		reset, all of the pools at once without knowing what types have been pooled.
+		*/
+		class ComponentPoolBase {
+		public:
+			virtual ~ComponentPoolBase() {}
+
+			virtual ComponentPoolStats GetStats() const = 0;
+			virtual bool Reset() = 0;
+
+			static void GetAllStats(std::vector<ComponentPoolStats>& stats) {
+				for (ComponentPoolBase* p : GetPools()) {
+					stats.emplace_back(p->GetStats());
+				}
+			}
+
+			static void ResetAll() {
+				for (ComponentPoolBase* p : GetPools()) {
+					p->Reset();
+				}
+			}
+
+		protected:
+			static std::vector<ComponentPoolBase*>& GetPools() {
+				static std::vector<ComponentPoolBase*> pools;
+				return pools;
+			}
+		};
+
+		/*
+		A slab allocator for one component type. Memory is grabbed SlabSize objects at a
+		time, so objects of the same type end up next to each other rather than wherever
+		the heap put them. Freed blocks go on a free list to be handed out again, and
+		fresh blocks are bumped off the end of the current slab.
+
+		Reset is O(1) - it just rewinds the bump pointer back to the start of the first
+		slab, keeping the slabs around for the next level. It refuses to do anything
+		while objects are still alive.
+
+		Not thread safe! Components should only be created and destroyed on the game thread.
+		*/
+		template<class T, size_t SlabSize = 256>
+		class ComponentPool : public ComponentPoolBase {
+		public:
+			static ComponentPool& Get() {
+				static ComponentPool pool;
+				return pool;
+			}
+
+			void* Allocate() {
+				totalAllocations++;
+				liveCount++;
+				if (liveCount > peakCount) {
+					peakCount = liveCount;
+				}
+				if (freeList) {
+					Block* b = freeList;
+					freeList = b->next;
+					return b;
+				}
+				if (slabIndex == slabs.size()) {
+					slabs.emplace_back(new Block[SlabSize]);
+				}
+				void* b = &slabs[slabIndex][slabUsed];
+				if (++slabUsed == SlabSize) {
+					slabIndex++;
+					slabUsed = 0;
+				}
+				return b;
+			}
+
+			// makes sure the next count allocations won't need a new slab (ignoring the free list)
+			void Reserve(size_t count) {
+				size_t available = (slabs.size() - slabIndex) * SlabSize - slabUsed;
+				while (available < count) {
+					slabs.emplace_back(new Block[SlabSize]);
+					available += SlabSize;
+				}
+			}
+
+			void Free(void* p) {
+				Block* b = (Block*)p;
+				b->next = freeList;
+				freeList = b;
+				liveCount--;
+			}
+
+			void CountFallback() {
+				fallbackAllocations++;
+			}
+
+			bool Reset() override {
+				if (liveCount > 0) {
+					return false;
+				}
+				freeList	= nullptr;
+				slabIndex	= 0;
+				slabUsed	= 0;
+				return true;
+			}
+
+			ComponentPoolStats GetStats() const override {
+				ComponentPoolStats s;
+				s.name					= typeid(T).name();
+				s.liveCount				= liveCount;
+				s.peakCount				= peakCount;
+				s.totalAllocations		= totalAllocations;
+				s.fallbackAllocations	= fallbackAllocations;
+				s.slabCount				= slabs.size();
+				s.capacity				= slabs.size() * SlabSize;
+				return s;
+			}
+
+		protected:
+			ComponentPool() {
+				GetPools().emplace_back(this);
+			}
+			~ComponentPool() {
+				for (Block* s : slabs) {
+					delete[] s;
+				}
+			}
+
+			union Block {
+				Block* next;
+				alignas(T) char data[sizeof(T)];
+			};
+
+			std::vector<Block*> slabs;
+			Block*	freeList	= nullptr;
+			size_t	slabIndex	= 0;
+			size_t	slabUsed	= 0;
+
+			size_t liveCount			= 0;
+			size_t peakCount			= 0;
+			size_t totalAllocations		= 0;
+			size_t fallbackAllocations	= 0;
+		};
+
+		/*
+		Inherit from this (PooledComponent<MyClass>) to make new/delete of MyClass come
+		from its ComponentPool. Subclasses that are bigger than T go to the normal heap,
+		so T needs a virtual destructor if it's going to be deleted through a base pointer.
+		*/
+		template<class T>
+		class PooledComponent {
+		public:
+			static void* operator new(size_t size) {
+				if (size != sizeof(T)) {
+					ComponentPool<T>::Get().CountFallback();
+					return ::operator new(size);
+				}
+				return ComponentPool<T>::Get().Allocate();
+			}
+
+			static void operator delete(void* p, size_t size) {
+				if (!p) {
+					return;
+				}
+				if (size != sizeof(T)) {
+					::operator delete(p);
+					return;
+				}
+				ComponentPool<T>::Get().Free(p);
+			}
+		};
+	}
+}
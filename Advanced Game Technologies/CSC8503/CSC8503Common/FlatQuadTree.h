@@ -0,0 +1,178 @@
+#pragma once
+#include "../../Common/Vector2.h"
+#include "CollisionDetection.h"
+#include "QuadTree.h"
+#include <vector>
+#include <functional>
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		// a view of one leaf's entries, which all sit next to each other in the tree's entry array
+		template<class T>
+		struct QuadTreeSpan {
+			QuadTreeEntry<T>*	first;
+			size_t				count;
+
+			QuadTreeEntry<T>* begin() const {
+				return first;
+			}
+
+			QuadTreeEntry<T>* end() const {
+				return first + count;
+			}
+
+			size_t size() const {
+				return count;
+			}
+
+			QuadTreeEntry<T>& operator[](size_t i) const {
+				return first[i];
+			}
+		};
+
+		/*
+		Works the same as the QuadTree, but without any per node allocations - nodes all sit in
+		one array and refer to their children by index, and entries are kept in a shared pool,
+		with each leaf keeping a linked list of indices into it while the tree is being built.
+		Before the contents are operated on, each leaf's entries are copied next to each other,
+		so every leaf can be handed over as a single span.
+
+		Reset just empties the arrays without giving their memory back, so a tree that gets
+		rebuilt every frame (like the physics broadphase) only allocates until it's warmed up.
+		*/
+		template<class T>
+		class FlatQuadTree
+		{
+		public:
+			typedef std::function<void(QuadTreeSpan<T>)> QuadTreeSpanFunc;
+
+			FlatQuadTree(Vector2 size, int maxDepth = 6, int maxSize = 5) {
+				rootSize		= size;
+				this->maxDepth	= maxDepth;
+				this->maxSize	= maxSize;
+				Reset();
+			}
+			~FlatQuadTree() {
+			}
+
+			void Reset() {
+				nodes.clear();
+				entries.clear();
+				leafContents.clear();
+				nodes.emplace_back(Node(Vector2(), rootSize, maxDepth));
+				compacted = true;
+			}
+
+			void Insert(T object, const Vector3& pos, const Vector3& size) {
+				InsertIntoNode(0, QuadTreeEntry<T>(object, pos, size));
+				compacted = false;
+			}
+
+			void OperateOnContents(QuadTreeSpanFunc func) {
+				Compact();
+				for (const Node& n : nodes) {
+					if (n.firstChild < 0 && n.count > 0) {
+						func(QuadTreeSpan<T>{ &leafContents[n.firstEntry], (size_t)n.count });
+					}
+				}
+			}
+
+			int NodeCount() const {
+				return (int)nodes.size();
+			}
+
+		protected:
+			struct Node {
+				Vector2 position;
+				Vector2 size;
+				int		depthLeft;
+				int		firstChild;	// the 4 children are always next to each other, -1 for a leaf
+				int		head;		// first pooled entry while building
+				int		count;
+				int		firstEntry;	// index into leafContents once compacted
+
+				Node(Vector2 pos, Vector2 size, int depthLeft) {
+					position		= pos;
+					this->size		= size;
+					this->depthLeft	= depthLeft;
+					firstChild		= -1;
+					head			= -1;
+					count			= 0;
+					firstEntry		= 0;
+				}
+			};
+
+			struct PooledEntry {
+				QuadTreeEntry<T>	entry;
+				int					next;
+			};
+
+			void InsertIntoNode(int nodeIndex, const QuadTreeEntry<T>& entry) {
+				const Node& n = nodes[nodeIndex];
+				if (!CollisionDetection::AABBTest(entry.pos, Vector3(n.position.x, 0, n.position.y), entry.size, Vector3(n.size.x, 1000.0f, n.size.y)))
+					return;
+				if (n.firstChild >= 0) {
+					int firstChild = n.firstChild;
+					for (int i = 0; i < 4; ++i)
+						InsertIntoNode(firstChild + i, entry);
+					return;
+				}
+				entries.push_back(PooledEntry{ entry, n.head });
+				Node& leaf	= nodes[nodeIndex];
+				leaf.head	= (int)entries.size() - 1;
+				leaf.count++;
+				if (leaf.count > maxSize && leaf.depthLeft > 0)
+					Split(nodeIndex);
+			}
+
+			// same child layout as QuadTreeNode::Split. nodes may reallocate, so no references are kept
+			void Split(int nodeIndex) {
+				Vector2 halfSize	= nodes[nodeIndex].size / 2.0f;
+				Vector2 position	= nodes[nodeIndex].position;
+				int depthLeft		= nodes[nodeIndex].depthLeft - 1;
+				int firstChild		= (int)nodes.size();
+
+				nodes.emplace_back(Node(position + Vector2(-halfSize.x, halfSize.y), halfSize, depthLeft));
+				nodes.emplace_back(Node(position + Vector2(halfSize.x, halfSize.y), halfSize, depthLeft));
+				nodes.emplace_back(Node(position + Vector2(-halfSize.x, -halfSize.y), halfSize, depthLeft));
+				nodes.emplace_back(Node(position + Vector2(halfSize.x, -halfSize.y), halfSize, depthLeft));
+
+				int head = nodes[nodeIndex].head;
+				nodes[nodeIndex].firstChild	= firstChild;
+				nodes[nodeIndex].head		= -1;
+				nodes[nodeIndex].count		= 0;
+
+				// the old pooled entries are just left behind until the next Reset
+				for (int i = head; i >= 0; i = entries[i].next) {
+					QuadTreeEntry<T> entry = entries[i].entry;
+					for (int j = 0; j < 4; ++j)
+						InsertIntoNode(firstChild + j, entry);
+				}
+			}
+
+			void Compact() {
+				if (compacted)
+					return;
+				leafContents.clear();
+				for (Node& n : nodes) {
+					if (n.firstChild >= 0)
+						continue;
+					n.firstEntry = (int)leafContents.size();
+					for (int i = n.head; i >= 0; i = entries[i].next)
+						leafContents.emplace_back(entries[i].entry);
+				}
+				compacted = true;
+			}
+
+			std::vector<Node>				nodes;
+			std::vector<PooledEntry>		entries;
+			std::vector<QuadTreeEntry<T>>	leafContents;
+
+			Vector2 rootSize;
+			int		maxDepth;
+			int		maxSize;
+			bool	compacted;
+		};
+	}
+}
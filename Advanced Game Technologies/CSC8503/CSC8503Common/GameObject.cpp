@@ -1,17 +1,32 @@
 #include "GameObject.h"
 #include "CollisionDetection.h"
+#include "GameWorld.h"
 
 using namespace NCL::CSC8503;
 
+namespace {
+	// IDs are handed back out, so the component arrays' lookup tables stay as small as possible
+	std::vector<unsigned int>	freeEntityIDs;
+	unsigned int				nextEntityID = 0;
+}
+
 GameObject::GameObject(string objectName)	{
 	name			= objectName;
 	isActive		= true;
-	isCollectable	= false;
 	boundingVolume	= nullptr;
 	physicsObject	= nullptr;
 	renderObject	= nullptr;
 	networkObject	= nullptr;
-	stateDescription = "";
+	worldTreeHandle	= -1;
+	world			= nullptr;
+
+	if (freeEntityIDs.empty()) {
+		entityID = nextEntityID++;
+	}
+	else {
+		entityID = freeEntityIDs.back();
+		freeEntityIDs.pop_back();
+	}
 	//layer			= Layer::NONE;
 }
 
@@ -20,6 +35,76 @@ GameObject::~GameObject()	{
 	delete physicsObject;
 	delete renderObject;
 	delete networkObject;
+
+	ComponentArrayBase::RemoveFromShared(entityID);
+	freeEntityIDs.emplace_back(entityID);
+}
+
+void GameObject::SetActive(bool active) {
+	isActive = active;
+	if (world) {
+		world->UpdateObjectComponents(this);
+	}
+}
+
+void GameObject::SetRenderObject(RenderObject* newObject) {
+	renderObject = newObject;
+	if (world) {
+		world->UpdateObjectComponents(this);
+	}
+}
+
+void GameObject::SetPhysicsObject(PhysicsObject* newObject) {
+	physicsObject = newObject;
+	if (world) {
+		world->UpdateObjectComponents(this);
+	}
+}
+
+void GameObject::SetCollisionType(CollisionType type) {
+	if (!physicsObject) {
+		return;
+	}
+	physicsObject->SetCollisionType(type);
+	if (world) {
+		world->UpdateObjectComponents(this);
+	}
+}
+
+void GameObject::SetCollectable(bool isCollectable) {
+	AddComponent<CollectableComponent>(CollectableComponent{ isCollectable, IsCollected() });
+}
+
+bool GameObject::IsCollectable() const {
+	CollectableComponent* c = GetComponent<CollectableComponent>();
+	return c && c->isCollectable;
+}
+
+void GameObject::SetCollected(bool collected) {
+	AddComponent<CollectableComponent>(CollectableComponent{ IsCollectable(), collected });
+}
+
+bool GameObject::IsCollected() const {
+	CollectableComponent* c = GetComponent<CollectableComponent>();
+	return c && c->collected;
+}
+
+void GameObject::SetStateDescription(const string& description) {
+	AddComponent<AIStateComponent>().description = description;
+}
+
+string GameObject::GetStateDescription() const {
+	AIStateComponent* c = GetComponent<AIStateComponent>();
+	return c ? c->description : "";
+}
+
+void GameObject::SetSpawnPos(const Vector3& pos) {
+	AddComponent<SpawnComponent>().position = pos;
+}
+
+Vector3 GameObject::GetSpawnPos() const {
+	SpawnComponent* c = GetComponent<SpawnComponent>();
+	return c ? c->position : Vector3();
 }
 
 bool GameObject::GetBroadphaseAABB(Vector3&outSize) const {
@@ -30,22 +115,45 @@ bool GameObject::GetBroadphaseAABB(Vector3&outSize) const {
 	return true;
 }
 
-//These would be better as a virtual 'ToAABB' type function, really...
 void GameObject::UpdateBroadphaseAABB() {
 	if (!boundingVolume) {
 		return;
 	}
+	broadphaseAABB = CalculateAABB(GetConstPhysicsTransform());
+}
+
+// unlike the broadphase AABB this uses the game's transform, so is safe to use while physics is threaded
+bool GameObject::GetWorldAABB(Vector3& outPos, Vector3& outSize) const {
+	if (!boundingVolume) {
+		return false;
+	}
+	outPos	= transform.GetWorldPosition();
+	outSize	= CalculateAABB(transform);
+	return true;
+}
+
+bool GameObject::GetAABB(const Transform& t, Vector3& outSize) const {
+	if (!boundingVolume) {
+		return false;
+	}
+	outSize = CalculateAABB(t);
+	return true;
+}
+
+//These would be better as a virtual 'ToAABB' type function, really...
+Vector3 GameObject::CalculateAABB(const Transform& t) const {
 	if (boundingVolume->type == VolumeType::AABB) {
-		broadphaseAABB = ((AABBVolume&)*boundingVolume).GetHalfDimensions();
+		return ((AABBVolume&)*boundingVolume).GetHalfDimensions();
 	}
 	else if (boundingVolume->type == VolumeType::Sphere) {
 		float r = ((SphereVolume&)*boundingVolume).GetRadius();
-		broadphaseAABB = Vector3(r, r, r);
+		return Vector3(r, r, r);
 	}
 	else if (boundingVolume->type == VolumeType::OBB) {
-		Matrix3 mat = Matrix3(transform.GetWorldOrientation());
+		Matrix3 mat = Matrix3(t.GetWorldOrientation());
 		mat = mat.Absolute();
 		Vector3 halfSizes = ((OBBVolume&)*boundingVolume).GetHalfDimensions();
-		broadphaseAABB = mat * halfSizes;
+		return mat * halfSizes;
 	}
+	return Vector3();
 }
\ No newline at end of file
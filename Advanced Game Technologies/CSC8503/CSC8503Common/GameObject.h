@@ -5,6 +5,8 @@
 #include "PhysicsObject.h"
 #include "RenderObject.h"
 #include "NetworkObject.h"
+#include "ComponentArray.h"
+#include "GameplayComponents.h"
 
 #include <vector>
 
@@ -18,8 +20,31 @@ namespace NCL {
 		};*/
 
 		class NetworkObject;
+		class GameWorld;
+
+		/*
+		Given out by GameWorld::AddGameObject. Slots get reused once an object is removed, but
+		the generation goes up each time, so old handles stop finding anything rather than
+		finding whatever took the slot over.
+		*/
+		struct GameObjectHandle {
+			unsigned int index		= ~0u;
+			unsigned int generation	= 0;
+
+			bool IsValid() const {
+				return index != ~0u;
+			}
+
+			bool operator==(const GameObjectHandle& other) const {
+				return index == other.index && generation == other.generation;
+			}
+
+			bool operator!=(const GameObjectHandle& other) const {
+				return !(*this == other);
+			}
+		};
 
-		class GameObject	{
+		class GameObject : public PooledComponent<GameObject>	{
 		public:
 			GameObject(string name = "");
 			virtual ~GameObject();
@@ -36,12 +61,38 @@ namespace NCL {
 				return isActive;
 			}
 
-			// @TODO make collectableObject class...
-			void SetCollectable(bool isCollectable) { this->isCollectable = isCollectable; }
-			bool IsCollectable() const { return isCollectable; }
+			// inactive objects aren't drawn
+			void SetActive(bool active);
+
+			/*
+			Components stored outside the object, in ComponentArray<T>::Shared(), keyed by
+			the object's entity ID. They're removed when the object is deleted.
+			*/
+			template<class T>
+			T* GetComponent() const {
+				return ComponentArray<T>::Shared().Get(entityID);
+			}
+
+			template<class T>
+			T& AddComponent(const T& component = T()) {
+				return ComponentArray<T>::Shared().Add(entityID, component);
+			}
+
+			template<class T>
+			void RemoveComponent() {
+				ComponentArray<T>::Shared().Remove(entityID);
+			}
+
+			// unique among live objects, but reused once an object is deleted
+			unsigned int GetEntityID() const {
+				return entityID;
+			}
+
+			void SetCollectable(bool isCollectable);
+			bool IsCollectable() const;
 
-			void SetCollected(bool collected) { this->collected = collected; }
-			bool IsCollected() const { return collected; }
+			void SetCollected(bool collected);
+			bool IsCollected() const;
 
 			const Transform& GetConstTransform() const {
 				return transform;
@@ -51,6 +102,15 @@ namespace NCL {
 				return transform;
 			}
 
+			// the transform physics works on - only differs from GetTransform while physics is threaded
+			const Transform& GetConstPhysicsTransform() const {
+				return physicsObject ? *physicsObject->GetTransform() : transform;
+			}
+
+			Transform& GetPhysicsTransform() {
+				return physicsObject ? *physicsObject->GetTransform() : transform;
+			}
+
 			RenderObject* GetRenderObject() const {
 				return renderObject;
 			}
@@ -63,13 +123,11 @@ namespace NCL {
 				return networkObject;
 			}
 
-			void SetRenderObject(RenderObject* newObject) {
-				renderObject = newObject;
-			}
+			void SetRenderObject(RenderObject* newObject);
+			void SetPhysicsObject(PhysicsObject* newObject);
 
-			void SetPhysicsObject(PhysicsObject* newObject) {
-				physicsObject = newObject;
-			}
+			// changes the physics object's collision type, and moves the object to its new list in the world
+			void SetCollisionType(CollisionType type);
 
 			const string& GetName() const {
 				return name;
@@ -86,20 +144,36 @@ namespace NCL {
 
 			void UpdateBroadphaseAABB();
 
+			bool GetWorldAABB(Vector3& outPos, Vector3& outSize) const;
+			// the AABB the object would have with the given transform
+			bool GetAABB(const Transform& t, Vector3& outSize) const;
+
+			// where this object is in the GameWorld's quadtree, -1 if it isn't
+			void SetWorldTreeHandle(int handle) { worldTreeHandle = handle; }
+			int GetWorldTreeHandle() const { return worldTreeHandle; }
+
+			// invalid if the object isn't in a GameWorld
+			void SetWorldHandle(GameWorld* world, GameObjectHandle handle) {
+				this->world	= world;
+				worldHandle	= handle;
+			}
+			GameObjectHandle GetWorldHandle() const { return worldHandle; }
+
 			void SetCollidedWith(CollisionType collisionType) { this->collisionType = collisionType; }
 			CollisionType HasCollidedWith() { return collisionType; }
 
 			/*void SetLayer(Layer layer) { this->layer = layer; }
 			Layer GetLayer() const { return layer; }*/
 
-			// @TODO make AIObject class
-			void SetStateDescription(string description) { stateDescription = description; }
-			string GetStateDescription() const { return stateDescription; }
+			void SetStateDescription(const string& description);
+			string GetStateDescription() const;
 
-			void SetSpawnPos(const Vector3& pos) { spawnPos = pos; }
-			Vector3 GetSpawnPos() const { return spawnPos; }
+			void SetSpawnPos(const Vector3& pos);
+			Vector3 GetSpawnPos() const;
 
 		protected:
+			Vector3 CalculateAABB(const Transform& t) const;
+
 			Transform			transform;
 
 			CollisionVolume*	boundingVolume;
@@ -109,21 +183,19 @@ namespace NCL {
 
 			bool	isActive;
 
-			// @TODO put in collectableObj class
-			bool	isCollectable;
-			bool	collected;
-
 			string	name;
 
-			// @TODO put in AIObj class
-			string	stateDescription;
-
 			Vector3 broadphaseAABB;
 
 			CollisionType collisionType;
 
-			Vector3 spawnPos;
 			//Layer layer;
+
+			int worldTreeHandle;
+
+			unsigned int		entityID;
+			GameWorld*			world;
+			GameObjectHandle	worldHandle;
 		};
 	}
 }
@@ -59,6 +59,22 @@ bool GameServer::SendGlobalPacket(GamePacket& packet) {
 	return true;
 }
 
+bool GameServer::SendPacketToPeer(int peerID, GamePacket& packet) {
+	if (!netHandle || peerID < 0 || peerID >= (int)netHandle->peerCount) {
+		return false;
+	}
+	ENetPeer* peer = &netHandle->peers[peerID];
+	if (peer->state != ENET_PEER_STATE_CONNECTED) {
+		return false;
+	}
+	ENetPacket* dataPacket = enet_packet_create(&packet, packet.GetTotalSize(), 0);
+	if (enet_peer_send(peer, 0, dataPacket) < 0) {
+		enet_packet_destroy(dataPacket); //only freed for us once it's been queued
+		return false;
+	}
+	return true;
+}
+
 void GameServer::UpdateServer() {
 	if (!netHandle) {
 		return;
@@ -83,7 +99,9 @@ void GameServer::UpdateServer() {
 		}
 		else if (type == ENetEventType::ENET_EVENT_TYPE_RECEIVE) {
 			GamePacket* packet = (GamePacket*)event.packet->data;
-			ProcessPacket(packet, peer);
+			if (IsWholePacket(event.packet)) {
+				ProcessPacket(packet, peer);
+			}
 		}
 		enet_packet_destroy(event.packet);
 	}
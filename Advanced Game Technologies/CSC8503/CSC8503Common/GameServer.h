@@ -22,6 +22,9 @@ namespace NCL {
 			bool SendGlobalPacket(int msgID);
 			bool SendGlobalPacket(GamePacket& packet);
 
+			//peerID is the ID the client's packets arrive with
+			bool SendPacketToPeer(int peerID, GamePacket& packet);
+
 			virtual void UpdateServer();
 
 		protected:
@@ -4,6 +4,7 @@
 #include "CollisionDetection.h"
 #include "../../Common/Camera.h"
 #include <algorithm>
+#include <unordered_map>
 
 using namespace NCL;
 using namespace NCL::CSC8503;
@@ -11,47 +12,279 @@ using namespace NCL::CSC8503;
 GameWorld::GameWorld()	{
 	mainCamera = new Camera();
 
-	quadTree = nullptr;
+	quadTree = new QuadTree<GameObject*>(Vector2(1024, 1024), 7, 6);
 
 	shuffleConstraints	= false;
 	shuffleObjects		= false;
+
+	worldStateCounter	= 0;
+
+	broadphaseStructure	= BroadphaseStructure::QUADTREE;
 }
 
 GameWorld::~GameWorld()	{
+	delete quadTree;
+	for (Prototype& p : prototypes) {
+		for (GameObject* o : p.freeInstances) {
+			delete o;
+		}
+	}
 }
 
 void GameWorld::Clear() {
+	ProcessRemovals();	// finish off anything that was waiting to be removed
+
+	for (GameObject* i : gameObjects) {
+		i->SetWorldTreeHandle(-1);
+		i->SetWorldHandle(nullptr, GameObjectHandle());
+	}
+	renderObjects.Clear();
+	for (ComponentArray<GameObject*>& list : typeIndex) {
+		list.Clear();
+	}
+	// every handle given out so far becomes stale
+	for (unsigned int i = 0; i < objectSlots.size(); ++i) {
+		if (objectSlots[i].objectIndex >= 0) {
+			objectSlots[i].objectIndex = -1;
+			objectSlots[i].generation++;
+			freeSlots.emplace_back(i);
+		}
+	}
+	delete quadTree;
+	quadTree = new QuadTree<GameObject*>(Vector2(1024, 1024), 7, 6);
+
 	gameObjects.clear();
 	constraints.clear();
+	worldStateCounter++;
 }
 
 void GameWorld::ClearAndErase() {
+	ProcessRemovals();	// objects removed with deleteObject false aren't ours to delete
+
 	for (auto& i : gameObjects) {
 		delete i;
 	}
 	for (auto& i : constraints) {
 		delete i;
 	}
+	gameObjects.clear();	// so Clear doesn't touch the deleted objects
 	Clear();
+	// everything's been handed back, so the pools can rewind rather than keep a free list
+	ComponentPoolBase::ResetAll();
+}
+
+GameObjectHandle GameWorld::AddGameObject(GameObject* o) {
+	GameObjectHandle handle = AllocateHandle(o);
+	UpdateObjectComponents(o);
+	InsertIntoQuadTree(o);
+	worldStateCounter++;
+	for (auto& c : additionCallbacks) {
+		c.second(o);
+	}
+	return handle;
 }
 
-void GameWorld::AddGameObject(GameObject* o) {
+void GameWorld::AddGameObjects(const std::vector<GameObject*>& objects) {
+	gameObjects.reserve(gameObjects.size() + objects.size());
+	if (objects.size() > freeSlots.size()) {
+		objectSlots.reserve(objectSlots.size() + objects.size() - freeSlots.size());
+	}
+	quadTree->Reserve(objects.size());
+
+	for (GameObject* o : objects) {
+		AllocateHandle(o);
+		UpdateObjectComponents(o);
+	}
+	for (GameObject* o : objects) {
+		InsertIntoQuadTree(o);
+	}
+	// a step per object, so callbacks can keep up one object at a time
+	for (GameObject* o : objects) {
+		worldStateCounter++;
+		for (auto& c : additionCallbacks) {
+			c.second(o);
+		}
+	}
+}
+
+// gives the object a slot and puts it on the end of the object list
+GameObjectHandle GameWorld::AllocateHandle(GameObject* o) {
+	GameObjectHandle handle;
+	if (freeSlots.empty()) {
+		handle.index = (unsigned int)objectSlots.size();
+		objectSlots.emplace_back(ObjectSlot());
+	}
+	else {
+		handle.index = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	ObjectSlot& slot	= objectSlots[handle.index];
+	slot.objectIndex	= (int)gameObjects.size();
+	slot.removalPending	= false;
+	handle.generation	= slot.generation;
+
+	o->SetWorldHandle(this, handle);
 	gameObjects.emplace_back(o);
+	return handle;
+}
+
+void GameWorld::RemoveGameObject(GameObject* o, bool deleteObject) {
+	QueueRemoval(o, deleteObject, -1);
+}
+
+void GameWorld::QueueRemoval(GameObject* o, bool deleteObject, int prototype) {
+	GameObjectHandle handle = o->GetWorldHandle();
+	if (GetGameObject(handle) != o || objectSlots[handle.index].removalPending) {
+		return;	// not in this world, or already on its way out
+	}
+	objectSlots[handle.index].removalPending = true;
+	pendingRemovals.emplace_back(PendingRemoval{ o, deleteObject, prototype });
+}
+
+GameObject* GameWorld::GetGameObject(GameObjectHandle handle) const {
+	if (handle.index >= objectSlots.size()) {
+		return nullptr;
+	}
+	const ObjectSlot& slot = objectSlots[handle.index];
+	if (slot.generation != handle.generation || slot.objectIndex < 0) {
+		return nullptr;
+	}
+	return gameObjects[slot.objectIndex];
+}
+
+int GameWorld::AddRemovalCallback(GameObjectFunc f) {
+	removalCallbacks.emplace_back(nextCallbackID, f);
+	return nextCallbackID++;
+}
+
+void GameWorld::RemoveRemovalCallback(int id) {
+	removalCallbacks.erase(std::remove_if(removalCallbacks.begin(), removalCallbacks.end(),
+		[&](const std::pair<int, GameObjectFunc>& c) { return c.first == id; }), removalCallbacks.end());
+}
+
+int GameWorld::AddAdditionCallback(GameObjectFunc f) {
+	additionCallbacks.emplace_back(nextCallbackID, f);
+	return nextCallbackID++;
+}
+
+void GameWorld::RemoveAdditionCallback(int id) {
+	additionCallbacks.erase(std::remove_if(additionCallbacks.begin(), additionCallbacks.end(),
+		[&](const std::pair<int, GameObjectFunc>& c) { return c.first == id; }), additionCallbacks.end());
+}
+
+/*
+The last object is moved into the removed object's place, so removing is the same
+cost however many objects there are - the price is that the object list's order
+changes, which nothing should be relying on anyway (see ShuffleObjects!).
+*/
+void GameWorld::ProcessRemovals() {
+	// callbacks might remove more objects, so don't hold on to iterators
+	for (size_t r = 0; r < pendingRemovals.size(); ++r) {
+		PendingRemoval removal = pendingRemovals[r];
+		GameObject* o = removal.object;
+
+		ObjectSlot& slot	= objectSlots[o->GetWorldHandle().index];
+		GameObject* moved	= gameObjects.back();
+		gameObjects[slot.objectIndex] = moved;
+		objectSlots[moved->GetWorldHandle().index].objectIndex = slot.objectIndex;
+		gameObjects.pop_back();
+		ReleaseHandle(o);
+
+		if (o->GetWorldTreeHandle() >= 0) {
+			quadTree->Remove(QuadTreeHandle{ o->GetWorldTreeHandle() });
+			o->SetWorldTreeHandle(-1);
+		}
+		worldStateCounter++;
+
+		for (auto& c : removalCallbacks) {
+			c.second(o);
+		}
+		if (removal.prototype >= 0) {
+			o->SetActive(false);
+			prototypes[removal.prototype].freeInstances.emplace_back(o);
+		}
+		else if (removal.deleteObject) {
+			delete o;
+		}
+	}
+	pendingRemovals.clear();
+}
+
+int GameWorld::RegisterPrototype(PrototypeFunc create) {
+	Prototype p;
+	p.create = create;
+	prototypes.emplace_back(p);
+	return (int)prototypes.size() - 1;
+}
+
+GameObjectHandle GameWorld::AcquireInstance(int prototype, const Vector3& position) {
+	Prototype& p = prototypes[prototype];
+	GameObject* o = nullptr;
+	if (p.freeInstances.empty()) {
+		o = p.create();
+		o->AddComponent<PrototypeInstanceComponent>().prototype = prototype;
+	}
+	else {
+		o = p.freeInstances.back();
+		p.freeInstances.pop_back();
+	}
+	// whatever it was doing when it was released shouldn't carry on
+	o->GetTransform().SetWorldPosition(position);
+	if (PhysicsObject* physics = o->GetPhysicsObject()) {
+		physics->SetLinearVelocity(Vector3());
+		physics->SetAngularVelocity(Vector3());
+		physics->ClearForces();
+	}
+	o->SetCollidedWith(CollisionType::DEFAULT);
+	o->SetActive(true);
+	return AddGameObject(o);
 }
 
-void GameWorld::RemoveGameObject(GameObject* o) {
-	std::remove(gameObjects.begin(), gameObjects.end(), o);
+void GameWorld::ReleaseInstance(GameObjectHandle handle) {
+	GameObject* o = GetGameObject(handle);
+	if (!o) {
+		return;
+	}
+	PrototypeInstanceComponent* instance = o->GetComponent<PrototypeInstanceComponent>();
+	if (!instance) {
+		return;	// not one of ours, RemoveGameObject it instead
+	}
+	QueueRemoval(o, false, instance->prototype);
 }
 
-/*void GameWorld::InitCollectableObjects() {
-	for (GameObject* i : gameObjects)
-		if ((*i).IsCollectable())
-			collectableObjects.emplace_back(i);
+void GameWorld::ReleaseHandle(GameObject* o) {
+	unsigned int index	= o->GetWorldHandle().index;
+	ObjectSlot& slot	= objectSlots[index];
+	slot.objectIndex	= -1;
+	slot.removalPending	= false;
+	slot.generation++;
+	freeSlots.emplace_back(index);
+	o->SetWorldHandle(nullptr, GameObjectHandle());
+	renderObjects.Remove(o->GetEntityID());
+	for (ComponentArray<GameObject*>& list : typeIndex) {
+		list.Remove(o->GetEntityID());
+	}
 }
 
-void GameWorld::RemoveCollectableObject(GameObject* o) {
-	std::remove(collectableObjects.begin(), collectableObjects.end(), o);
-}*/
+void GameWorld::UpdateObjectComponents(GameObject* o) {
+	if (o->IsActive() && o->GetRenderObject()) {
+		renderObjects.Add(o->GetEntityID(), o->GetRenderObject());
+	}
+	else {
+		renderObjects.Remove(o->GetEntityID());
+	}
+
+	// it might have been retagged, so take it out of whichever list it was in before
+	int type = o->GetPhysicsObject() ? (int)o->GetPhysicsObject()->GetCollisionType() : -1;
+	for (int i = 0; i < numCollisionTypes; ++i) {
+		if (i == type) {
+			typeIndex[i].Add(o->GetEntityID(), o);
+		}
+		else {
+			typeIndex[i].Remove(o->GetEntityID());
+		}
+	}
+}
 
 void GameWorld::GetObjectIterators(
 	GameObjectIterator& first,
@@ -62,16 +295,19 @@ void GameWorld::GetObjectIterators(
 }
 
 void GameWorld::OperateOnContents(GameObjectFunc f) {
-	for (GameObject* g : gameObjects) {
-		f(g);
-	}
+	ForEach(f);
 }
 
 void GameWorld::UpdateWorld(float dt) {
+	ProcessRemovals();
 	UpdateTransforms();
+	UpdateQuadTree();
 
 	if (shuffleObjects) {
 		std::random_shuffle(gameObjects.begin(), gameObjects.end());
+		for (int i = 0; i < (int)gameObjects.size(); ++i) {
+			objectSlots[gameObjects[i]->GetWorldHandle().index].objectIndex = i;
+		}
 	}
 
 	if (shuffleConstraints) {
@@ -79,45 +315,137 @@ void GameWorld::UpdateWorld(float dt) {
 	}
 }
 
+void GameWorld::UpdateBounds() {
+	UpdateTransforms();
+	UpdateQuadTree();
+}
+
+/*
+Only transforms that have been changed since last frame (or whose parent has) are
+updated, so the static parts of the level cost next to nothing. Different roots can't
+affect each other, so with enough transforms the array is split up into runs of whole
+subtrees, which get updated on the worker threads.
+*/
 void GameWorld::UpdateTransforms() {
-	for (auto& i : gameObjects) {
-		i->GetTransform().UpdateMatrices();
+	if (transformListState != worldStateCounter || transformHierarchyState != Transform::GetHierarchyVersion()) {
+		BuildTransformList();
 	}
+	if (transformJobStarts.size() <= 2) {
+		UpdateTransformRange(0, sortedTransforms.size());
+		return;
+	}
+	workerPool.ParallelFor(transformJobStarts.size() - 1, [&](size_t job) {
+		UpdateTransformRange(transformJobStarts[job], transformJobStarts[job + 1]);
+	});
 }
 
-void GameWorld::UpdateQuadTree() {
-	delete quadTree;
+void GameWorld::UpdateTransformRange(size_t first, size_t last) {
+	for (size_t i = first; i < last; ++i) {
+		Transform* t	= sortedTransforms[i];
+		int parent		= transformParents[i];
+		bool changed	= t->IsDirty() || (parent >= 0 && transformChanged[parent]);
+		if (changed) {
+			t->UpdateMatrices();
+		}
+		transformChanged[i] = changed;
+	}
+}
 
-	//quadTree = new QuadTree<GameObject*>(Vector2(512, 512), 6);
+void GameWorld::BuildTransformList() {
+	sortedTransforms.clear();
+	transformParents.clear();
+	transformJobStarts.clear();
 
-	//for (auto& i : gameObjects) {
-	//	quadTree->Insert(i);
-	//}
-}
+	std::unordered_map<const Transform*, int> inWorld;
+	for (GameObject* o : gameObjects) {
+		inWorld[&o->GetTransform()] = -1;
+	}
 
-bool GameWorld::Raycast(Ray& r, RayCollision& closestCollision, bool closestObject) const {
-	//The simplest raycast just goes through each object and sees if there's a collision
-	RayCollision collision;
-	for (auto& i : gameObjects) {
-		if (!i->GetBoundingVolume()) { //objects might not be collideable etc...
-			continue;
+	// depth first from every root, so each subtree ends up in one piece
+	std::vector<Transform*> roots;
+	for (GameObject* o : gameObjects) {
+		Transform* t = &o->GetTransform();
+		if (!t->GetParent() || inWorld.find(t->GetParent()) == inWorld.end()) {
+			roots.emplace_back(t);
 		}
-		RayCollision thisCollision;
-		if (CollisionDetection::RayIntersection(r, *i, thisCollision)) {
-			
-			if (!closestObject) {	
-				closestCollision		= collision;
-				closestCollision.node = i;
-				return true;
-			}
-			else {
-				if (thisCollision.rayDistance < collision.rayDistance) {
-					thisCollision.node = i;
-					collision = thisCollision;
+	}
+
+	size_t minJobSize = 256;
+	size_t jobSize = std::max(minJobSize, gameObjects.size() / (workerPool.GetThreadCount() + 1) + 1);
+
+	std::vector<Transform*> stack;
+	for (Transform* root : roots) {
+		if (transformJobStarts.empty() || sortedTransforms.size() - transformJobStarts.back() >= jobSize) {
+			transformJobStarts.emplace_back(sortedTransforms.size());
+		}
+		stack.emplace_back(root);
+		while (!stack.empty()) {
+			Transform* t = stack.back();
+			stack.pop_back();
+
+			auto parent = inWorld.find(t->GetParent());
+			inWorld[t] = (int)sortedTransforms.size();
+			transformParents.emplace_back(parent == inWorld.end() ? -1 : parent->second);
+			sortedTransforms.emplace_back(t);
+
+			for (Transform* c : t->GetChildren()) {
+				if (inWorld.find(c) != inWorld.end()) {
+					stack.emplace_back(c);
 				}
 			}
 		}
 	}
+	transformJobStarts.emplace_back(sortedTransforms.size());
+	transformChanged.assign(sortedTransforms.size(), 0);
+
+	transformListState		= worldStateCounter;
+	transformHierarchyState	= Transform::GetHierarchyVersion();
+}
+
+/*
+The tree is kept from frame to frame, and objects are only moved around in it
+if their AABB has actually changed since last time, which for most of the level
+(floors, walls, collectables sat waiting) it won't have.
+*/
+void GameWorld::UpdateQuadTree() {
+	for (GameObject* i : gameObjects) {
+		if (i->GetWorldTreeHandle() < 0) {
+			InsertIntoQuadTree(i); // might have been given a volume after being added
+			continue;
+		}
+		Vector3 pos;
+		Vector3 halfSizes;
+		if (i->GetWorldAABB(pos, halfSizes)) {
+			quadTree->Update(QuadTreeHandle{ i->GetWorldTreeHandle() }, pos, halfSizes);
+		}
+	}
+}
+
+void GameWorld::InsertIntoQuadTree(GameObject* o) {
+	Vector3 pos;
+	Vector3 halfSizes;
+	if (!o->GetWorldAABB(pos, halfSizes)) {
+		return;
+	}
+	o->SetWorldTreeHandle(quadTree->Insert(o, pos, halfSizes).index);
+}
+
+/*
+Rather than testing every object, the quadtree hands us the objects whose AABBs
+the ray passes through, nearest first. Once something's been hit, the tree won't
+bother with anything further away than it - or with anything at all, if we just
+want to know if the ray hits something.
+*/
+bool GameWorld::Raycast(Ray& r, RayCollision& closestCollision, bool closestObject) const {
+	RayCollision collision;
+	quadTree->QueryRay(r, [&](GameObject* i, float& maxDistance) {
+		RayCollision thisCollision;
+		if (CollisionDetection::RayIntersection(r, *i, thisCollision) && thisCollision.rayDistance < collision.rayDistance) {
+			thisCollision.node	= i;
+			collision			= thisCollision;
+			maxDistance			= closestObject ? thisCollision.rayDistance : -1.0f;
+		}
+	});
 	if (collision.node) {
 		closestCollision		= collision;
 		closestCollision.node	= collision.node;
@@ -133,10 +461,12 @@ Constraint Tutorial Stuff
 
 void GameWorld::AddConstraint(Constraint* c) {
 	constraints.emplace_back(c);
+	worldStateCounter++;
 }
 
 void GameWorld::RemoveConstraint(Constraint* c) {
-	std::remove(constraints.begin(), constraints.end(), c);
+	constraints.erase(std::remove(constraints.begin(), constraints.end(), c), constraints.end());
+	worldStateCounter++;
 }
 
 void GameWorld::GetConstraintIterators(
@@ -1,18 +1,74 @@
 #pragma once
 #include <vector>
+#include <algorithm>
 #include "Ray.h"
 #include "CollisionDetection.h"
 #include "QuadTree.h"
+#include "Octree.h"
+#include "WorkerPool.h"
+#include "ComponentArray.h"
 namespace NCL {
 		class Camera;
 		using Maths::Ray;
 	namespace CSC8503 {
 		class GameObject;
 		class Constraint;
+		class RenderObject;
 
 		typedef std::function<void(GameObject*)> GameObjectFunc;
+		typedef std::function<GameObject*()> PrototypeFunc;
 		typedef std::vector<GameObject*>::const_iterator GameObjectIterator;
 
+		// quadtrees are fine for flat levels, but everything at the same x/z ends up in the same leaf
+		enum class BroadphaseStructure {
+			QUADTREE,
+			OCTREE
+		};
+
+		/*
+		How ForEachWith<T> gets at an object's T - the components GameObject holds itself have
+		their own getters, anything else lives in the object's shared ComponentArrays.
+		*/
+		template<class T>
+		struct ObjectComponent {
+			static T* Get(GameObject* o) { return o->GetComponent<T>(); }
+		};
+
+		template<>
+		struct ObjectComponent<PhysicsObject> {
+			static PhysicsObject* Get(GameObject* o) { return o->GetPhysicsObject(); }
+		};
+
+		template<>
+		struct ObjectComponent<RenderObject> {
+			static RenderObject* Get(GameObject* o) { return o->GetRenderObject(); }
+		};
+
+		template<>
+		struct ObjectComponent<NetworkObject> {
+			static NetworkObject* Get(GameObject* o) { return o->GetNetworkObject(); }
+		};
+
+		/*
+		A packed run of objects, straight out of one of the world's lists - only valid until
+		objects are next added to or removed from the world, so don't hold on to one.
+		*/
+		struct GameObjectSpan {
+			GameObject* const*	first	= nullptr;
+			GameObject* const*	last	= nullptr;
+
+			GameObject* const* begin() const	{ return first; }
+			GameObject* const* end() const		{ return last; }
+			size_t size() const					{ return last - first; }
+			bool empty() const					{ return first == last; }
+			GameObject* operator[](size_t i) const { return first[i]; }
+		};
+
+		// added to every object made by GameWorld::AcquireInstance, so it knows where to go back to
+		struct PrototypeInstanceComponent {
+			int prototype = -1;
+		};
+
 		class GameWorld	{
 		public:
 			GameWorld();
@@ -21,8 +77,75 @@ namespace NCL {
 			void Clear();
 			void ClearAndErase();
 
-			void AddGameObject(GameObject* o);
-			void RemoveGameObject(GameObject* o);
+			GameObjectHandle AddGameObject(GameObject* o);
+
+			/*
+			Adds a whole level's worth of objects in one go - the lists only grow once, and the
+			world state counter only goes up once, so systems rebuild their caches once
+			rather than once for every object. Handles are given out as GetWorldHandle.
+			*/
+			void AddGameObjects(const std::vector<GameObject*>& objects);
+
+			/*
+			Objects aren't taken out straight away, as something further up the call stack might
+			be looping over them - they stay in the world (and their handles stay valid) until the
+			start of the next UpdateWorld. If deleteObject is false, the object is the caller's
+			to delete once it's gone.
+			*/
+			void RemoveGameObject(GameObject* o, bool deleteObject = true);
+
+			// nullptr if the object has since been removed
+			GameObject* GetGameObject(GameObjectHandle handle) const;
+
+			/*
+			Called for each object as it leaves the world, after it's been taken out of the object
+			list and the world state counter has gone up, but before it's deleted - so anything
+			caching object pointers can let go of them. Returns an ID for RemoveRemovalCallback.
+			*/
+			int AddRemovalCallback(GameObjectFunc f);
+			void RemoveRemovalCallback(int id);
+
+			// the same for objects joining the world, called once they're in the object list and
+			// the world state counter has gone up for them
+			int AddAdditionCallback(GameObjectFunc f);
+			void RemoveAdditionCallback(int id);
+
+			/*
+			Pools of objects that get spawned and got rid of over and over. A prototype's function
+			builds a new object (without adding it to the world), and is only called when there
+			are no released instances to reuse. Prototypes last for the lifetime of the world, as do
+			released instances - ClearAndErase only deletes the instances still in the world.
+
+			Released instances are taken out of the world just like RemoveGameObject (so physics,
+			the broadphase, rendering and networking all forget about them) and deactivated, but
+			kept around for the next AcquireInstance rather than deleted.
+			*/
+			int RegisterPrototype(PrototypeFunc create);
+			GameObjectHandle AcquireInstance(int prototype, const Vector3& position);
+			void ReleaseInstance(GameObjectHandle handle);
+
+			// released instances waiting to be reused
+			size_t GetFreeInstanceCount(int prototype) const {
+				return prototypes[prototype].freeInstances.size();
+			}
+
+			// the render object of every active object in the world that has one, keyed by entity ID
+			const ComponentArray<RenderObject*>& GetRenderObjects() const {
+				return renderObjects;
+			}
+
+			/*
+			Every object in the world whose physics object has the given collision type, so
+			gameplay can get at all the collectables (or all the AI) without going through
+			every object. Use GameObject::SetCollisionType to change type once it's been added.
+			*/
+			GameObjectSpan GetObjectsOfType(CollisionType type) const {
+				const ComponentArray<GameObject*>& list = typeIndex[(int)type];
+				return GameObjectSpan{ list.Data(), list.Data() + list.Size() };
+			}
+
+			// called by GameObject when it's given a new component or type, so the arrays above stay up to date
+			void UpdateObjectComponents(GameObject* o);
 
 			void AddConstraint(Constraint* c);
 			void RemoveConstraint(Constraint* c);
@@ -43,8 +166,62 @@ namespace NCL {
 
 			virtual void UpdateWorld(float dt);
 
+			// brings the transforms and quadtree up to date with anything moved since UpdateWorld,
+			// such as by physics, so culling and raycasts see where things are now
+			void UpdateBounds();
+
 			void OperateOnContents(GameObjectFunc f);
 
+			/*
+			The templated versions of OperateOnContents - the visitor's type is known here, so
+			calls to it can be inlined rather than going through a std::function every object.
+			Don't add or remove objects from inside them (removal is deferred anyway).
+			*/
+			template<class Func>
+			void ForEach(Func&& f) const {
+				for (GameObject* o : gameObjects) {
+					f(o);
+				}
+			}
+
+			// only objects with a T, which is passed along as well - f(GameObject*, T&)
+			template<class T, class Func>
+			void ForEachWith(Func&& f) const {
+				for (GameObject* o : gameObjects) {
+					if (T* c = ObjectComponent<T>::Get(o)) {
+						f(o, *c);
+					}
+				}
+			}
+
+			/*
+			Splits the objects into chunks and hands them out to the worker pool, so f gets
+			called on several threads at once - it mustn't touch anything shared with other
+			objects without locking. Each chunk is one call through the pool's std::function,
+			the objects within it call f directly. Don't call this from another thread while
+			the world is updating, as the pool is shared with UpdateWorld.
+			*/
+			template<class Func>
+			void ParallelForEach(Func&& f, size_t chunkSize = 64) {
+				ParallelForEach(gameObjects.begin(), gameObjects.end(), f, chunkSize);
+			}
+
+			// the same, for some other list of objects (a system's own list of bodies, say)
+			template<class Iterator, class Func>
+			void ParallelForEach(Iterator first, Iterator last, Func&& f, size_t chunkSize = 64) {
+				size_t count = last - first;
+				if (chunkSize == 0) {
+					chunkSize = 1;
+				}
+				workerPool.ParallelFor((count + chunkSize - 1) / chunkSize, [&](size_t chunk) {
+					Iterator begin	= first + chunk * chunkSize;
+					Iterator end	= first + std::min(count, (chunk + 1) * chunkSize);
+					for (Iterator i = begin; i != end; ++i) {
+						f(*i);
+					}
+				});
+			}
+
 			void GetObjectIterators(
 				GameObjectIterator& first,
 				GameObjectIterator& last) const;
@@ -53,12 +230,76 @@ namespace NCL {
 				std::vector<Constraint*>::const_iterator& first,
 				std::vector<Constraint*>::const_iterator& last) const;
 
+			void SetBroadphaseStructure(BroadphaseStructure structure) {
+				broadphaseStructure = structure;
+				worldStateCounter++;	// so physics rebuilds its trees
+			}
+
+			BroadphaseStructure GetBroadphaseStructure() const {
+				return broadphaseStructure;
+			}
+
+			// every object with a bounding volume, updated as they move
+			QuadTree<GameObject*>* GetQuadTree() const {
+				return quadTree;
+			}
+
+			// changes whenever objects or constraints are added or removed, so systems caching them know to rebuild
+			int GetWorldStateCounter() const {
+				return worldStateCounter;
+			}
+
+			WorkerPool& GetWorkerPool() {
+				return workerPool;
+			}
+
 		protected:
+			GameObjectHandle AllocateHandle(GameObject* o);
+			void QueueRemoval(GameObject* o, bool deleteObject, int prototype);
+			void ProcessRemovals();
+			void ReleaseHandle(GameObject* o);
+
 			void UpdateTransforms();
+			void BuildTransformList();
+			void UpdateTransformRange(size_t first, size_t last);
 			void UpdateQuadTree();
+			void InsertIntoQuadTree(GameObject* o);
 
 			std::vector<GameObject*> gameObjects;
 
+			// what each handle index points at - objects are kept packed in gameObjects, so this
+			// lets removal find an object and fill its gap with the last one without searching
+			struct ObjectSlot {
+				int				objectIndex		= -1;	// into gameObjects, -1 if the slot is free
+				unsigned int	generation		= 0;
+				bool			removalPending	= false;
+			};
+			std::vector<ObjectSlot>		objectSlots;
+			std::vector<unsigned int>	freeSlots;
+
+			struct PendingRemoval {
+				GameObject* object;
+				bool		deleteObject;
+				int			prototype;	// which prototype's pool to go back into, -1 if it isn't going back
+			};
+			std::vector<PendingRemoval> pendingRemovals;
+
+			std::vector<std::pair<int, GameObjectFunc>> removalCallbacks;
+			std::vector<std::pair<int, GameObjectFunc>> additionCallbacks;
+			int nextCallbackID = 0;
+
+			ComponentArray<RenderObject*> renderObjects;
+
+			// one list per CollisionType, keyed by entity ID like renderObjects
+			static const int numCollisionTypes = (int)CollisionType::NONE + 1;
+			ComponentArray<GameObject*> typeIndex[numCollisionTypes];
+
+			struct Prototype {
+				PrototypeFunc				create;
+				std::vector<GameObject*>	freeInstances;
+			};
+			std::vector<Prototype> prototypes;
+
 			std::vector<Constraint*> constraints;
 
 			QuadTree<GameObject*>* quadTree;
@@ -67,6 +308,21 @@ namespace NCL {
 
 			bool shuffleConstraints;
 			bool shuffleObjects;
+
+			int worldStateCounter;
+
+			BroadphaseStructure broadphaseStructure;
+
+			// every object's transform, parents always before their children, so one pass in order
+			// updates a whole hierarchy. each root's subtree is a contiguous run of the array
+			std::vector<Transform*>	sortedTransforms;
+			std::vector<int>		transformParents;	// index into sortedTransforms, -1 for roots
+			std::vector<char>		transformChanged;	// did the matrices change this frame
+			std::vector<size_t>		transformJobStarts;	// where each ParallelFor job starts, always on a root
+			int transformListState		= -1;
+			int transformHierarchyState	= -1;
+
+			WorkerPool workerPool;
 		};
 	}
 }
@@ -0,0 +1,27 @@
+#pragma once
+#include "../../Common/Vector3.h"
+#include <string>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Gameplay data that only a handful of objects have, and that physics and rendering
+		never look at. It's kept in ComponentArrays rather than in GameObject itself, so the
+		per-frame loops over objects aren't dragging it through the cache.
+		*/
+		struct CollectableComponent {
+			bool isCollectable	= false;
+			bool collected		= false;
+		};
+
+		// where the object started off, for anything that can be sent back there
+		struct SpawnComponent {
+			Maths::Vector3 position;
+		};
+
+		// shown by the debug object info display
+		struct AIStateComponent {
+			std::string description;
+		};
+	}
+}
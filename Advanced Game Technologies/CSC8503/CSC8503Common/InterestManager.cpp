@@ -0,0 +1,52 @@
+#include "InterestManager.h"
+#include "GameWorld.h"
+#include "NetworkObject.h"
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+InterestManager::InterestManager(GameWorld& world, float relevantRadius) : world(world), relevantRadius(relevantRadius) {
+}
+
+void InterestManager::BeginTick() {
+	alwaysRelevant.clear();
+	notInTree.clear();
+	world.ForEachWith<NetworkObject>([&](GameObject* o, NetworkObject& n) {
+		for (const RelevanceRule& rule : rules) {
+			if (rule(*o)) {
+				alwaysRelevant.emplace_back(&n);
+				return;
+			}
+		}
+		if (o->GetWorldTreeHandle() < 0) {
+			notInTree.emplace_back(o);
+		}
+	});
+}
+
+void InterestManager::GetRelevantObjects(const Vector3& viewer, std::vector<NetworkObject*>& out) {
+	out = alwaysRelevant;
+
+	queryResults.clear();
+	world.GetQuadTree()->QuerySphere(viewer, relevantRadius, queryResults);
+	for (GameObject* o : queryResults) {
+		if (o->GetNetworkObject()) {
+			out.emplace_back(o->GetNetworkObject());
+		}
+	}
+	for (GameObject* o : notInTree) {
+		if ((o->GetTransform().GetWorldPosition() - viewer).LengthSquared() < relevantRadius * relevantRadius) {
+			out.emplace_back(o->GetNetworkObject());
+		}
+	}
+	// an always relevant object might be close by too
+	std::sort(out.begin(), out.end(), [](NetworkObject* a, NetworkObject* b) {
+		return a->GetNetworkID() < b->GetNetworkID();
+	});
+	out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+void InterestManager::GetAlwaysRelevantObjects(std::vector<NetworkObject*>& out) const {
+	out = alwaysRelevant;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "../../Common/Vector3.h"
+#include <vector>
+#include <functional>
+
+namespace NCL {
+	using namespace Maths;
+	namespace CSC8503 {
+		class GameWorld;
+		class GameObject;
+		class NetworkObject;
+
+		/*
+		Works out which networked objects each client needs to be sent, so a client only
+		gets the objects around its own player rather than the whole world. Objects are
+		relevant if they're within relevantRadius of the player - found with a query on the
+		world's quadtree, so it only ever looks at that bit of the world - or if one of the
+		rules says they're always relevant (things on the scoreboard, say, or the other
+		players).
+
+		Call BeginTick once per server tick, before any GetRelevantObjects calls, so the
+		rules only need running once per object rather than once per object per client.
+		*/
+		class InterestManager {
+		public:
+			// true if the object should go to every client, wherever they are
+			typedef std::function<bool(GameObject&)> RelevanceRule;
+
+			InterestManager(GameWorld& world, float relevantRadius = 100.0f);
+
+			void AddAlwaysRelevantRule(const RelevanceRule& rule) {
+				rules.emplace_back(rule);
+			}
+
+			void SetRelevantRadius(float radius) {
+				relevantRadius = radius;
+			}
+
+			float GetRelevantRadius() const {
+				return relevantRadius;
+			}
+
+			void BeginTick();
+
+			// what a client whose player is at viewer should be sent, each object once
+			void GetRelevantObjects(const Vector3& viewer, std::vector<NetworkObject*>& out);
+
+			// for a client that's yet to get a player
+			void GetAlwaysRelevantObjects(std::vector<NetworkObject*>& out) const;
+
+		protected:
+			GameWorld&	world;
+			float		relevantRadius;
+
+			std::vector<RelevanceRule>	rules;
+
+			// rebuilt by BeginTick
+			std::vector<NetworkObject*>	alwaysRelevant;
+			std::vector<GameObject*>	notInTree;	// no volume, so the quadtree can't find them
+
+			std::vector<GameObject*>	queryResults;
+		};
+	}
+}
@@ -0,0 +1,368 @@
+#include "LevelFile.h"
+#include "GameWorld.h"
+#include "GameObject.h"
+#include "RenderObject.h"
+#include "AABBVolume.h"
+#include "OBBVolume.h"
+#include "SphereVolume.h"
+#include "../../Common/Assets.h"
+
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	const char		LEVEL_MAGIC[4]	= { 'G', 'L', 'V', 'L' };
+	const uint32_t	LEVEL_VERSION	= 1;
+
+	const uint8_t	FLAG_PHYSICS		= 1;
+	const uint8_t	FLAG_COLLECTABLE	= 2;
+	const uint8_t	FLAG_SPAWN_POINT	= 4;
+
+	const size_t	HEADER_SIZE	= 16;	// magic, version, object count, name block size
+	const size_t	RECORD_SIZE	= 22 * sizeof(float) + 4 + 4 * 2 + 4;	// see Save
+
+	/*
+	Everything is copied in and out a field at a time rather than writing the structs out
+	directly, so the file doesn't change with padding, or the SIMD maths types' alignment.
+	*/
+	class Writer {
+	public:
+		Writer(std::vector<char>& data) : data(data) {}
+
+		template<class T>
+		void Write(T value) {
+			size_t at = data.size();
+			data.resize(at + sizeof(T));
+			memcpy(&data[at], &value, sizeof(T));
+		}
+
+		void Write(const Vector3& v)	{ Write(v.x); Write(v.y); Write(v.z); }
+		void Write(const Vector4& v)	{ Write(v.x); Write(v.y); Write(v.z); Write(v.w); }
+		void Write(const Quaternion& q)	{ Write(q.x); Write(q.y); Write(q.z); Write(q.w); }
+
+	protected:
+		std::vector<char>& data;
+	};
+
+	class Reader {
+	public:
+		Reader(const char* data) : data(data) {}
+
+		template<class T>
+		T Read() {
+			T value;
+			memcpy(&value, data, sizeof(T));
+			data += sizeof(T);
+			return value;
+		}
+
+		Vector3 ReadVector3() {
+			Vector3 v;
+			v.x = Read<float>(); v.y = Read<float>(); v.z = Read<float>();
+			return v;
+		}
+
+		Vector4 ReadVector4() {
+			Vector4 v;
+			v.x = Read<float>(); v.y = Read<float>(); v.z = Read<float>(); v.w = Read<float>();
+			return v;
+		}
+
+		Quaternion ReadQuaternion() {
+			Quaternion q;
+			q.x = Read<float>(); q.y = Read<float>(); q.z = Read<float>(); q.w = Read<float>();
+			return q;
+		}
+
+	protected:
+		const char* data;
+	};
+
+	template<class T>
+	int FindAsset(const std::vector<T*>& assets, const T* asset) {
+		if (!asset) {
+			return -1;
+		}
+		auto i = std::find(assets.begin(), assets.end(), asset);
+		return i == assets.end() ? -1 : (int)(i - assets.begin());
+	}
+
+	template<class T>
+	T* GetAsset(const std::vector<T*>& assets, int index) {
+		return index >= 0 && index < (int)assets.size() ? assets[index] : nullptr;
+	}
+
+	// only the volumes Export can write
+	bool ValidVolume(uint8_t volume) {
+		return volume == 0 || volume == (uint8_t)VolumeType::AABB || volume == (uint8_t)VolumeType::OBB || volume == (uint8_t)VolumeType::Sphere;
+	}
+
+	bool ReadLevel(const std::string& filename, LevelData& level, int kindCount) {
+		std::ifstream file(Assets::DATADIR + filename, std::ios::binary | std::ios::ate);
+		if (!file) {
+			return false;
+		}
+		std::vector<char> data((size_t)file.tellg());
+		file.seekg(0);
+		if (data.size() < HEADER_SIZE || !file.read(data.data(), data.size())) {
+			return false;
+		}
+
+		Reader header(data.data());
+		if (memcmp(data.data(), LEVEL_MAGIC, 4) != 0) {
+			return false;
+		}
+		header.Read<uint32_t>();
+		uint32_t version	= header.Read<uint32_t>();
+		uint32_t count		= header.Read<uint32_t>();
+		uint32_t nameSize	= header.Read<uint32_t>();
+		// count's checked first, so nothing here can overflow on 32 bit builds
+		if (version != LEVEL_VERSION || count > (data.size() - HEADER_SIZE) / RECORD_SIZE ||
+			nameSize != data.size() - HEADER_SIZE - count * RECORD_SIZE) {
+			return false;
+		}
+		const char* names = data.data() + HEADER_SIZE + count * RECORD_SIZE;
+
+		level.objects.clear();
+		level.objects.resize(count);
+
+		Reader r(data.data() + HEADER_SIZE);
+		for (LevelObject& o : level.objects) {
+			o.position			= r.ReadVector3();
+			o.orientation		= r.ReadQuaternion();
+			o.scale				= r.ReadVector3();
+			o.volumeSize		= r.ReadVector3();
+			o.colour			= r.ReadVector4();
+			o.inverseInertia	= r.ReadVector3();
+			o.inverseMass		= r.Read<float>();
+			o.elasticity		= r.Read<float>();
+
+			uint32_t nameOffset	= r.Read<uint32_t>();
+			o.mesh				= r.Read<int16_t>();
+			o.texture			= r.Read<int16_t>();
+			o.shader			= r.Read<int16_t>();
+			o.kind				= r.Read<uint16_t>();
+
+			uint8_t volume		= r.Read<uint8_t>();
+			uint8_t collision	= r.Read<uint8_t>();
+			uint8_t body		= r.Read<uint8_t>();
+			uint8_t flags		= r.Read<uint8_t>();
+			if (!ValidVolume(volume) || collision > (uint8_t)CollisionType::NONE || body > (uint8_t)BodyType::DYNAMIC ||
+				o.mesh < -1 || o.texture < -1 || o.shader < -1 || (kindCount > 0 && o.kind >= kindCount)) {
+				return false;
+			}
+			o.volumeType		= volume ? (VolumeType)volume : VolumeType::Invalid;
+			o.collisionType		= (CollisionType)collision;
+			o.bodyType			= (BodyType)body;
+			o.hasPhysics		= (flags & FLAG_PHYSICS) != 0;
+			o.collectable		= (flags & FLAG_COLLECTABLE) != 0;
+			o.spawnPoint		= (flags & FLAG_SPAWN_POINT) != 0;
+
+			if (nameOffset >= nameSize) {
+				return false;
+			}
+			o.name = std::string(names + nameOffset, strnlen(names + nameOffset, nameSize - nameOffset));
+		}
+		return true;
+	}
+}
+
+bool LevelFile::Load(const std::string& filename, LevelData& level, int kindCount) {
+	if (!ReadLevel(filename, level, kindCount)) {
+		level.objects.clear();	// rather than leave it half loaded
+		return false;
+	}
+	return true;
+}
+
+bool LevelFile::Save(const std::string& filename, const LevelData& level) {
+	std::vector<char> data;
+	std::vector<char> names;
+	data.reserve(HEADER_SIZE + level.objects.size() * RECORD_SIZE);
+
+	Writer w(data);
+	data.insert(data.end(), LEVEL_MAGIC, LEVEL_MAGIC + 4);
+	w.Write(LEVEL_VERSION);
+	w.Write((uint32_t)level.objects.size());
+	size_t nameSizeAt = data.size();
+	w.Write((uint32_t)0);	// filled in once the names are all in
+
+	for (const LevelObject& o : level.objects) {
+		w.Write(o.position);
+		w.Write(o.orientation);
+		w.Write(o.scale);
+		w.Write(o.volumeSize);
+		w.Write(o.colour);
+		w.Write(o.inverseInertia);
+		w.Write(o.inverseMass);
+		w.Write(o.elasticity);
+
+		w.Write((uint32_t)names.size());
+		names.insert(names.end(), o.name.begin(), o.name.end());
+		names.emplace_back('\0');
+
+		w.Write((int16_t)o.mesh);
+		w.Write((int16_t)o.texture);
+		w.Write((int16_t)o.shader);
+		w.Write((uint16_t)o.kind);
+
+		w.Write((uint8_t)(o.volumeType == VolumeType::Invalid ? 0 : (int)o.volumeType));
+		w.Write((uint8_t)o.collisionType);
+		w.Write((uint8_t)o.bodyType);
+		w.Write((uint8_t)((o.hasPhysics ? FLAG_PHYSICS : 0) | (o.collectable ? FLAG_COLLECTABLE : 0) | (o.spawnPoint ? FLAG_SPAWN_POINT : 0)));
+	}
+	uint32_t nameSize = (uint32_t)names.size();
+	memcpy(&data[nameSizeAt], &nameSize, sizeof(nameSize));
+	data.insert(data.end(), names.begin(), names.end());
+
+	std::ofstream file(Assets::DATADIR + filename, std::ios::binary);
+	return file && file.write(data.data(), data.size());
+}
+
+void LevelFile::Export(const GameWorld& world, const LevelAssets& assets, LevelData& level) {
+	level.objects.clear();
+	world.ForEach([&](GameObject* g) {
+		if (!g->IsActive()) {
+			return;
+		}
+		LevelObject o;
+		o.name			= g->GetName();
+		o.position		= g->GetTransform().GetWorldPosition();
+		o.orientation	= g->GetTransform().GetLocalOrientation();
+		o.scale			= g->GetTransform().GetLocalScale();
+
+		if (const CollisionVolume* volume = g->GetBoundingVolume()) {
+			o.volumeType = volume->type;
+			switch (volume->type) {
+			case VolumeType::AABB:
+				o.volumeSize = ((const AABBVolume*)volume)->GetHalfDimensions(); break;
+			case VolumeType::OBB:
+				o.volumeSize = ((const OBBVolume*)volume)->GetHalfDimensions(); break;
+			case VolumeType::Sphere:
+				o.volumeSize = Vector3(((const SphereVolume*)volume)->GetRadius(), 0, 0); break;
+			default:
+				o.volumeType = VolumeType::Invalid; break;	// levels can't hold anything fancier yet
+			}
+		}
+		if (RenderObject* render = g->GetRenderObject()) {
+			o.mesh		= FindAsset(assets.meshes, render->GetMesh());
+			o.texture	= FindAsset(assets.textures, render->GetDefaultTexture());
+			o.shader	= FindAsset(assets.shaders, render->GetShader());
+			o.colour	= render->GetColour();
+		}
+		if (PhysicsObject* physics = g->GetPhysicsObject()) {
+			o.hasPhysics		= true;
+			o.inverseMass		= physics->GetInverseMass();
+			o.elasticity		= physics->GetElasticity();
+			o.inverseInertia	= physics->GetInverseInertia();
+			o.collisionType		= physics->GetCollisionType();
+			o.bodyType			= physics->GetBodyType();
+		}
+		o.collectable = g->IsCollectable();
+		if (LevelObjectKindComponent* kind = g->GetComponent<LevelObjectKindComponent>()) {
+			o.kind			= kind->kind;
+			o.spawnPoint	= kind->spawnPoint;
+		}
+		level.objects.emplace_back(o);
+	});
+}
+
+void LevelFile::Build(const LevelData& level, GameWorld& world, const LevelAssets& assets, LevelObjectFunc onObject,
+	std::vector<GameObject*>* built) {
+	size_t boxes	= 0;
+	size_t obbs		= 0;
+	size_t spheres	= 0;
+	size_t rendered	= 0;
+	size_t physical	= 0;
+	size_t count	= 0;
+	for (const LevelObject& o : level.objects) {
+		if (o.spawnPoint) {
+			continue;
+		}
+		count++;
+		boxes		+= o.volumeType == VolumeType::AABB;
+		obbs		+= o.volumeType == VolumeType::OBB;
+		spheres		+= o.volumeType == VolumeType::Sphere;
+		rendered	+= GetAsset(assets.meshes, o.mesh) && GetAsset(assets.shaders, o.shader);
+		physical	+= o.hasPhysics;
+	}
+	ComponentPool<GameObject>::Get().Reserve(count);
+	ComponentPool<AABBVolume>::Get().Reserve(boxes);
+	ComponentPool<OBBVolume>::Get().Reserve(obbs);
+	ComponentPool<SphereVolume>::Get().Reserve(spheres);
+	ComponentPool<RenderObject>::Get().Reserve(rendered);
+	ComponentPool<PhysicsObject>::Get().Reserve(physical);
+
+	std::vector<GameObject*> objects;
+	std::vector<const LevelObject*> records;
+	objects.reserve(count);
+	records.reserve(count);
+
+	for (const LevelObject& o : level.objects) {
+		if (o.spawnPoint) {
+			continue;
+		}
+		GameObject* g = new GameObject(o.name);
+		g->GetTransform().SetWorldScale(o.scale);
+		g->GetTransform().SetWorldPosition(o.position);
+		g->GetTransform().SetLocalOrientation(o.orientation);
+
+		switch (o.volumeType) {
+		case VolumeType::AABB:
+			g->SetBoundingVolume((CollisionVolume*)new AABBVolume(o.volumeSize)); break;
+		case VolumeType::OBB:
+			g->SetBoundingVolume((CollisionVolume*)new OBBVolume(o.volumeSize)); break;
+		case VolumeType::Sphere:
+			g->SetBoundingVolume((CollisionVolume*)new SphereVolume(o.volumeSize.x)); break;
+		default:
+			break;
+		}
+		// an ID that isn't in these tables leaves the object unrendered, rather than rendering with nothing
+		MeshGeometry*	mesh	= GetAsset(assets.meshes, o.mesh);
+		ShaderBase*		shader	= GetAsset(assets.shaders, o.shader);
+		if (mesh && shader) {
+			g->SetRenderObject(new RenderObject(&g->GetTransform(), mesh, GetAsset(assets.textures, o.texture), shader, o.colour));
+		}
+		if (o.hasPhysics) {
+			PhysicsObject* physics = new PhysicsObject(&g->GetTransform(), g->GetBoundingVolume());
+			physics->SetInverseMass(o.inverseMass);
+			physics->SetElasticity(o.elasticity);
+			physics->SetInverseInertia(o.inverseInertia);
+			physics->SetCollisionType(o.collisionType);
+			physics->SetBodyType(o.bodyType);
+			g->SetPhysicsObject(physics);
+		}
+		if (o.collectable) {
+			g->SetCollectable(true);
+			g->SetSpawnPos(o.position);
+		}
+		if (o.kind != 0) {
+			g->AddComponent<LevelObjectKindComponent>(LevelObjectKindComponent{ o.kind, false });
+		}
+		objects.emplace_back(g);
+		records.emplace_back(&o);
+	}
+	world.AddGameObjects(objects);
+	if (built) {
+		built->insert(built->end(), objects.begin(), objects.end());
+	}
+
+	if (!onObject) {
+		return;
+	}
+	for (size_t i = 0; i < objects.size(); ++i) {
+		if (records[i]->kind != 0) {
+			onObject(*records[i], objects[i]);
+		}
+	}
+	for (const LevelObject& o : level.objects) {
+		if (o.spawnPoint) {
+			onObject(o, nullptr);
+		}
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <functional>
+#include "../../Common/Vector3.h"
+#include "../../Common/Vector4.h"
+#include "../../Common/Quaternion.h"
+#include "../../Common/TextureBase.h"
+#include "../../Common/ShaderBase.h"
+#include "PhysicsObject.h"
+#include "CollisionVolume.h"
+
+namespace NCL {
+	class MeshGeometry;
+	using namespace NCL::Rendering;
+
+	namespace CSC8503 {
+		class GameWorld;
+		class GameObject;
+
+		/*
+		What the mesh, texture and shader IDs in a level refer to. The same tables have to be
+		used to load a level as were used to export it - so add new assets on the end, as
+		moving existing ones around changes what every saved level looks like.
+		*/
+		struct LevelAssets {
+			std::vector<MeshGeometry*>	meshes;
+			std::vector<TextureBase*>	textures;
+			std::vector<ShaderBase*>	shaders;
+		};
+
+		/*
+		Lets the game find the objects it cares about again once a level has been loaded.
+		Kinds mean whatever the game wants them to, 0 being plain scenery. Spawn points
+		aren't built by the loader at all - the game makes them itself (they might be
+		pooled, or a GameObject subclass), so only their position really matters.
+		*/
+		struct LevelObjectKindComponent {
+			int		kind		= 0;
+			bool	spawnPoint	= false;
+		};
+
+		// one object's worth of a level
+		struct LevelObject {
+			std::string		name;
+			Vector3			position;
+			Quaternion		orientation;
+			Vector3			scale;
+
+			VolumeType		volumeType		= VolumeType::Invalid;	// Invalid if it hasn't got one
+			Vector3			volumeSize;		// half sizes for boxes, radius in x for spheres
+
+			int				mesh			= -1;	// into LevelAssets, -1 if it isn't rendered
+			int				texture			= -1;
+			int				shader			= -1;
+			Vector4			colour;
+
+			bool			hasPhysics		= false;
+			float			inverseMass		= 0.0f;
+			float			elasticity		= 0.0f;
+			Vector3			inverseInertia;
+			CollisionType	collisionType	= CollisionType::DEFAULT;
+			BodyType		bodyType		= BodyType::DYNAMIC;
+
+			bool			collectable		= false;
+			int				kind			= 0;
+			bool			spawnPoint		= false;
+		};
+
+		struct LevelData {
+			std::vector<LevelObject> objects;
+		};
+
+		// called for each object with a kind once the level's in the world - object is nullptr for spawn points
+		typedef std::function<void(const LevelObject&, GameObject*)> LevelObjectFunc;
+
+		/*
+		Levels are saved as a small header, then a table of fixed size object records, then
+		every object's name packed into one block at the end - so loading is one read, and
+		then a walk along the table. Building a level from a LevelData is kept separate from
+		reading the file, so a game can hang on to its LevelData and rebuild the level again
+		(to reset it, say) without going anywhere near the disk.
+		*/
+		class LevelFile {
+		public:
+			/*
+			Filenames are relative to the data directory. A file with anything out of range
+			in it (including kinds at or past kindCount, if that isn't 0) isn't loaded at
+			all, and level is left empty.
+			*/
+			static bool Load(const std::string& filename, LevelData& level, int kindCount = 0);
+			static bool Save(const std::string& filename, const LevelData& level);
+
+			// everything active in the world, as it is right now
+			static void Export(const GameWorld& world, const LevelAssets& assets, LevelData& level);
+
+			/*
+			Every object is made before any of them go into the world, with the component
+			pools grown up front to fit them all, then they're added as one batch. If built
+			isn't null, the objects made (so not spawn points) are added to the end of it.
+			*/
+			static void Build(const LevelData& level, GameWorld& world, const LevelAssets& assets, LevelObjectFunc onObject = nullptr,
+				std::vector<GameObject*>* built = nullptr);
+		};
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <thread>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A fixed size ring buffer for passing data between exactly two threads - one
+		thread may only ever Push, and the other may only ever Pop. Neither side ever
+		waits on a lock, Push just fails if the consumer has fallen a whole buffer behind.
+
+		Capacity must be a power of two.
+		*/
+		template<class T, size_t Capacity>
+		class LockFreeQueue {
+			static_assert((Capacity & (Capacity - 1)) == 0, "LockFreeQueue capacity must be a power of two");
+		public:
+			LockFreeQueue() : buffer(Capacity) {
+				writeIndex	= 0;
+				readIndex	= 0;
+			}
+			~LockFreeQueue() {}
+
+			// producer thread only
+			bool Push(const T& item) {
+				size_t write	= writeIndex.load(std::memory_order_relaxed);
+				size_t next		= (write + 1) & (Capacity - 1);
+				if (next == readIndex.load(std::memory_order_acquire))
+					return false;	// full
+				buffer[write] = item;
+				writeIndex.store(next, std::memory_order_release);
+				return true;
+			}
+
+			// producer thread only. Waits for room rather than failing, so only use it if the
+			// consumer is sure to keep popping. Returns false if it had to wait
+			bool PushOrWait(const T& item) {
+				if (Push(item))
+					return true;
+				while (!Push(item))
+					std::this_thread::yield();
+				return false;
+			}
+
+			// consumer thread only
+			bool Pop(T& item) {
+				size_t read = readIndex.load(std::memory_order_relaxed);
+				if (read == writeIndex.load(std::memory_order_acquire))
+					return false;	// empty
+				item = buffer[read];
+				readIndex.store((read + 1) & (Capacity - 1), std::memory_order_release);
+				return true;
+			}
+
+			bool IsEmpty() const {
+				return readIndex.load(std::memory_order_acquire) == writeIndex.load(std::memory_order_acquire);
+			}
+
+			// only safe when neither thread is using the queue
+			void Clear() {
+				writeIndex	= 0;
+				readIndex	= 0;
+			}
+
+		protected:
+			std::vector<T> buffer;
+
+			// kept on separate cache lines so the two threads don't fight over them
+			alignas(64) std::atomic<size_t> writeIndex;
+			alignas(64) std::atomic<size_t> readIndex;
+		};
+	}
+}
@@ -20,6 +20,14 @@ void NetworkBase::Destroy() {
 	enet_deinitialize();
 }
 
+bool NetworkBase::IsWholePacket(const ENetPacket* packet) {
+	if (packet->dataLength < sizeof(GamePacket)) {
+		return false;
+	}
+	const GamePacket* header = (const GamePacket*)packet->data;
+	return header->size >= 0 && (size_t)header->GetTotalSize() <= packet->dataLength;
+}
+
 bool NetworkBase::ProcessPacket(GamePacket* packet, int peerID) {
 	PacketHandlerIterator firstHandler;
 	PacketHandlerIterator lastHandler;
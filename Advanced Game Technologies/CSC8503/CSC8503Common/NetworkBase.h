@@ -9,12 +9,13 @@ enum BasicNetworkMessages {
 	Hello,
 	Message,
 	String_Message,
-	Delta_State,	//1 byte per channel since the last state
+	Delta_State,	//quantised, bit-packed changes since a full state
 	Full_State,		//Full transform etc
 	Received_State, //received from a client, informs that its received packet n
 	Player_Connected,
 	Player_Disconnected,
-	Shutdown
+	Shutdown,
+	Snapshot		//lots of objects' states at once, see SnapshotBuilder
 };
 
 struct GamePacket {
@@ -30,7 +31,7 @@ struct GamePacket {
 		this->type	= type;
 	}
 
-	int GetTotalSize() {
+	int GetTotalSize() const {
 		return sizeof(GamePacket) + size;
 	}
 };
@@ -93,6 +94,9 @@ protected:
 
 	bool ProcessPacket(GamePacket* p, int peerID = -1);
 
+	//false if the packet's header claims more bytes than actually arrived
+	static bool IsWholePacket(const ENetPacket* packet);
+
 	typedef std::multimap<int, PacketReceiver*>::const_iterator PacketHandlerIterator;
 
 	bool GetPacketHandlers(int msgID, PacketHandlerIterator& first, PacketHandlerIterator& last) const {
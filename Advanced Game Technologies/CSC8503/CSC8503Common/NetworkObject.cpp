@@ -1,8 +1,62 @@
 #include "NetworkObject.h"
+#include "../../Common/Maths.h"
+#include <cmath>
+#include <algorithm>
 
 using namespace NCL;
 using namespace CSC8503;
 
+namespace {
+	/*
+	A field's written as one bit saying whether it's changed at all, then if it has,
+	each component's change. Anything that's sat still costs a bit per field. sent
+	gets what the client will end up with, so the server can tell how far out it is.
+	*/
+	bool WriteField(BitWriter& writer, const float* delta, float* sent, int count, const QuantisedFloat& q) {
+		uint32_t values[4];
+		bool changed = false;
+		for (int i = 0; i < count; ++i) {
+			if (!q.Quantise(delta[i], values[i])) {
+				return false;
+			}
+			changed |= values[i] != (uint32_t)q.Steps();
+		}
+		writer.WriteBool(changed);
+		if (changed) {
+			for (int i = 0; i < count; ++i) {
+				writer.Write(values[i], q.bits);
+				sent[i] += q.Dequantise(values[i]);
+			}
+		}
+		return !writer.HasOverflowed();
+	}
+
+	bool ReadField(BitReader& reader, float* value, int count, const QuantisedFloat& q) {
+		bool changed = false;
+		if (!reader.ReadBool(changed)) {
+			return false;
+		}
+		for (int i = 0; changed && i < count; ++i) {
+			float delta = 0.0f;
+			if (!reader.ReadQuantised(delta, q)) {
+				return false;
+			}
+			value[i] += delta;
+		}
+		return true;
+	}
+}
+
+void DeltaStats::Add(const DeltaStats& s) {
+	deltasWritten		+= s.deltasWritten;
+	fullFallbacks		+= s.fullFallbacks;
+	bitsWritten			+= s.bitsWritten;
+	maxPositionError	= std::max(maxPositionError, s.maxPositionError);
+	maxAngleError		= std::max(maxAngleError, s.maxAngleError);
+	totalPositionError	+= s.totalPositionError;
+	totalAngleError		+= s.totalAngleError;
+}
+
 NetworkObject::NetworkObject(GameObject& o, int id) : object(o)	{
 	deltaErrors = 0;
 	fullErrors  = 0;
@@ -13,6 +67,9 @@ NetworkObject::~NetworkObject()	{
 }
 
 bool NetworkObject::ReadPacket(GamePacket& p) {
+	if (!IsBigEnough(p)) {
+		return false;
+	}
 	if (p.type == Delta_State) {
 		return ReadDeltaPacket((DeltaPacket&)p);
 	}
@@ -22,34 +79,68 @@ bool NetworkObject::ReadPacket(GamePacket& p) {
 	return false; //this isn't a packet we care about!
 }
 
-bool NetworkObject::WritePacket(GamePacket** p, bool deltaFrame, int stateID) {
+bool NetworkObject::WritePacket(SnapshotBuilder& snapshot, bool deltaFrame, int stateID) {
 	if (deltaFrame) {
-		if (!WriteDeltaPacket(p, stateID)) {
-			return WriteFullPacket(p);
+		DeltaPacket dp;
+		if (WriteDeltaPacket(dp, stateID)) {
+			return snapshot.Add(dp);
 		}
 	}
-	return WriteFullPacket(p);
+	FullPacket fp;
+	return WriteFullPacket(fp, snapshot.GetTick()) && snapshot.Add(fp);
+}
+
+bool NetworkObject::IsBigEnough(const GamePacket& p) {
+	if (p.type == Delta_State) {
+		//the bit-packed data is as long as it needs to be, and the reader won't go past what's there
+		return p.GetTotalSize() >= (int)(sizeof(DeltaPacket) - DeltaPacket::MAX_DATA);
+	}
+	if (p.type == Full_State) {
+		return p.GetTotalSize() >= (int)sizeof(FullPacket);
+	}
+	return true;
+}
+
+int NetworkObject::GetPacketObjectID(const GamePacket& p) {
+	if (!IsBigEnough(p)) {
+		return -1;
+	}
+	if (p.type == Delta_State) {
+		return ((const DeltaPacket&)p).objectID;
+	}
+	if (p.type == Full_State) {
+		return ((const FullPacket&)p).objectID;
+	}
+	return -1;
 }
 //Client objects recieve these packets
 bool NetworkObject::ReadDeltaPacket(DeltaPacket &p) {
-	if (p.fullID != lastFullState.stateID) {
+	//the server deltas against the last full state we acked, which might not be the newest we've got
+	NetworkState fullState;
+	if (!GetNetworkState(p.fullID, fullState)) {
 		deltaErrors++; //can't delta this frame
 		return false;
 	}
 
 	UpdateStateHistory(p.fullID);
 
-	Vector3		fullPos			= lastFullState.position;
-	Quaternion  fullOrientation = lastFullState.orientation;
-
-	fullPos.x += p.pos[0];
-	fullPos.y += p.pos[1];
-	fullPos.z += p.pos[2];
+	Vector3		fullPos			= fullState.position;
+	Quaternion  fullOrientation = fullState.orientation;
 
-	fullOrientation.x += ((float)p.orientation[0]) / 127.0f;
-	fullOrientation.y += ((float)p.orientation[1]) / 127.0f;
-	fullOrientation.z += ((float)p.orientation[2]) / 127.0f;
-	fullOrientation.w += ((float)p.orientation[3]) / 127.0f;
+	BitReader reader(p.data, std::min(p.GetDataSize(), (int)DeltaPacket::MAX_DATA));
+	bool turned = false;
+	if (!ReadField(reader, fullPos.array, 3, quantisation.position) || !reader.ReadBool(turned)) {
+		deltaErrors++; //cut short
+		return false;
+	}
+	if (turned) {
+		uint32_t packed = 0;
+		if (!reader.Read(packed, QuaternionCompression::TotalBits(quantisation.orientationBits))) {
+			deltaErrors++;
+			return false;
+		}
+		fullOrientation = QuaternionCompression::Decompress(packed, quantisation.orientationBits);
+	}
 
 	object.GetTransform().SetWorldPosition(fullPos);
 	object.GetTransform().SetLocalOrientation(fullOrientation);
@@ -58,59 +149,93 @@ bool NetworkObject::ReadDeltaPacket(DeltaPacket &p) {
 }
 
 bool NetworkObject::ReadFullPacket(FullPacket &p) {
-	if (p.fullState.stateID < lastFullState.stateID) {
+	if (p.stateID < lastFullState.stateID) {
 		return false; // received an 'old' packet, ignore!
 	}
-	lastFullState = p.fullState;
+	lastFullState.stateID		= p.stateID;
+	lastFullState.position		= p.position;
+	lastFullState.orientation	= QuaternionCompression::Decompress(p.orientation, quantisation.orientationBits);
 
 	object.GetTransform().SetWorldPosition(lastFullState.position);
 	object.GetTransform().SetLocalOrientation(lastFullState.orientation);
 
-	stateHistory.emplace_back(lastFullState);
+	AddStateHistory(lastFullState);
 
 	return true;
 }
 
-bool NetworkObject::WriteDeltaPacket(GamePacket**p, int stateID) {
-	DeltaPacket* dp = new DeltaPacket();
-
-	dp->objectID = networkID;
+bool NetworkObject::WriteDeltaPacket(DeltaPacket& dp, int stateID) {
+	dp.objectID = networkID;
 
 	NetworkState state;
 	if (!GetNetworkState(stateID, state)) {
+		stats.fullFallbacks++;
 		return false; //can't delta!
 	}
 
-	dp->fullID = stateID;
+	dp.fullID = stateID;
 
 	Vector3		currentPos			= object.GetTransform().GetWorldPosition();
 	Quaternion  currentOrientation  = object.GetTransform().GetWorldOrientation();
 
-	currentPos			-= state.position;
-	currentOrientation  -= state.orientation;
+	Vector3		posDelta	= currentPos - state.position;
+	Vector3		sentPos		= state.position;
+
+	BitWriter writer(dp.data, DeltaPacket::MAX_DATA);
+	if (!WriteField(writer, posDelta.array, sentPos.array, 3, quantisation.position)) {
+		stats.fullFallbacks++;
+		return false; //moved too far to delta, send it all
+	}
+
+	//the full state's orientation is what the client decoded, so it packs to the same bits if it's not turned
+	int			orientationBits = quantisation.orientationBits;
+	uint32_t	packed			= QuaternionCompression::Compress(currentOrientation, orientationBits);
+	bool		turned			= packed != QuaternionCompression::Compress(state.orientation, orientationBits);
+	Quaternion	sentOrientation = turned ? QuaternionCompression::Decompress(packed, orientationBits) : state.orientation;
+
+	writer.WriteBool(turned);
+	if (turned) {
+		writer.Write(packed, QuaternionCompression::TotalBits(orientationBits));
+	}
+	if (writer.HasOverflowed()) {
+		stats.fullFallbacks++;
+		return false;
+	}
+	dp.SetDataSize(writer.GetBytesWritten());
 
-	dp->pos[0] = (char)currentPos.x;
-	dp->pos[1] = (char)currentPos.y;
-	dp->pos[2] = (char)currentPos.z;
+	float positionError = (sentPos - currentPos).Length();
+	float dot			= std::min(std::fabs(Quaternion::Dot(sentOrientation, currentOrientation)), 1.0f);
+	float angleError	= RadiansToDegrees(2.0f * std::acos(dot));
 
-	dp->orientation[0] = (char)(currentOrientation.x * 127.0f);
-	dp->orientation[1] = (char)(currentOrientation.y * 127.0f);
-	dp->orientation[2] = (char)(currentOrientation.z * 127.0f);
-	dp->orientation[3] = (char)(currentOrientation.w * 127.0f);
+	stats.deltasWritten++;
+	stats.bitsWritten			+= writer.GetBitsWritten();
+	stats.maxPositionError		= std::max(stats.maxPositionError, positionError);
+	stats.maxAngleError			= std::max(stats.maxAngleError, angleError);
+	stats.totalPositionError	+= positionError;
+	stats.totalAngleError		+= angleError;
 
-	*p = dp;
 	return true;
 }
 
-bool NetworkObject::WriteFullPacket(GamePacket**p) {
-	FullPacket* fp = new FullPacket();
+/*
+A full state is only made once per tick, however many clients it goes to, and it's
+named after the tick - so a client's ack means the same thing for every object, and
+the history only grows by one a tick.
+*/
+bool NetworkObject::WriteFullPacket(FullPacket& fp, int tick) {
+	if (stateHistory.empty() || stateHistory.back().stateID != tick) {
+		lastFullOrientation = QuaternionCompression::Compress(object.GetTransform().GetWorldOrientation(), quantisation.orientationBits);
 
-	fp->objectID				= networkID;
-	fp->fullState.position		= object.GetTransform().GetWorldPosition();
-	fp->fullState.orientation	= object.GetTransform().GetWorldOrientation();
-	fp->fullState.stateID		= lastFullState.stateID++;
-
-	*p = fp;
+		//deltas are written against what the clients ended up with
+		lastFullState.stateID		= tick;
+		lastFullState.position		= object.GetTransform().GetWorldPosition();
+		lastFullState.orientation	= QuaternionCompression::Decompress(lastFullOrientation, quantisation.orientationBits);
+		AddStateHistory(lastFullState);
+	}
+	fp.objectID		= networkID;
+	fp.stateID		= lastFullState.stateID;
+	fp.position		= lastFullState.position;
+	fp.orientation	= lastFullOrientation;
 	return true;
 }
 
@@ -118,6 +243,13 @@ NetworkState& NetworkObject::GetLatestNetworkState() {
 	return lastFullState;
 }
 
+void NetworkObject::AddStateHistory(const NetworkState& state) {
+	stateHistory.emplace_back(state);
+	if ((int)stateHistory.size() > MAX_STATE_HISTORY) {
+		stateHistory.erase(stateHistory.begin());
+	}
+}
+
 bool NetworkObject::GetNetworkState(int stateID, NetworkState& state) {
 	for (auto i = stateHistory.begin(); i < stateHistory.end(); ++i) {
 		if ((*i).stateID == stateID) {
@@ -2,11 +2,17 @@
 #include "GameObject.h"
 #include "NetworkBase.h"
 #include "NetworkState.h"
+#include "ComponentPool.h"
+#include "SnapshotBuilder.h"
+#include "BitStream.h"
+#include "QuaternionCompression.h"
 namespace NCL {
 	namespace CSC8503 {
 		struct FullPacket : public GamePacket {
-			int		objectID = -1;
-			NetworkState fullState;
+			int			objectID	= -1;
+			int			stateID		= -1;
+			Vector3		position;
+			uint32_t	orientation	= 0;	// see QuaternionCompression
 
 			FullPacket() {
 				type = Full_State;
@@ -15,56 +21,141 @@ namespace NCL {
 		};
 
 		struct DeltaPacket : public GamePacket {
+			static const int MAX_DATA = 32;
+
 			int		fullID		= -1;
 			int		objectID	= -1;
-			char	pos[3];
-			char	orientation[4];
+			char	data[MAX_DATA];	// bit-packed changes since fullID, see NetworkObject::WriteDeltaPacket
 
 			DeltaPacket() {
 				type = Delta_State;
-				size = sizeof(DeltaPacket) - sizeof(GamePacket);
+				SetDataSize(MAX_DATA);
+			}
+
+			// only as much of data as was written gets sent
+			void SetDataSize(int bytes) {
+				size = (short)(data + bytes - (char*)this - sizeof(GamePacket));
+			}
+
+			int GetDataSize() const {
+				return GetTotalSize() - (int)(data - (const char*)this);
 			}
 		};
 
+		/*
+		How each field of a delta is squeezed down. Each one's a change since the last
+		full state, so the ranges only need to cover how far an object can move between
+		them - anything further and a full state is sent instead. The server and clients
+		have to agree on these!
+		*/
+		struct DeltaQuantisation {
+			QuantisedFloat position		= QuantisedFloat::WithPrecision(16.0f, 0.001f);	// per axis, in metres
+			// orientations aren't deltas - they're sent whole, smallest three, in full states too
+			int orientationBits			= QuaternionCompression::DEFAULT_COMPONENT_BITS;
+		};
+
+		// what the server's deltas have cost, and how far out they've left the clients
+		struct DeltaStats {
+			int		deltasWritten		= 0;
+			int		fullFallbacks		= 0;	// out of range, or no full state to delta from
+			int		bitsWritten			= 0;
+			float	maxPositionError	= 0.0f;	// metres
+			float	maxAngleError		= 0.0f;	// degrees
+			float	totalPositionError	= 0.0f;
+			float	totalAngleError		= 0.0f;
+
+			float AverageBits() const {
+				return deltasWritten ? bitsWritten / (float)deltasWritten : 0.0f;
+			}
+
+			float AveragePositionError() const {
+				return deltasWritten ? totalPositionError / deltasWritten : 0.0f;
+			}
+
+			float AverageAngleError() const {
+				return deltasWritten ? totalAngleError / deltasWritten : 0.0f;
+			}
+
+			// for totalling up every object's stats
+			void Add(const DeltaStats& s);
+		};
+
+		// sent by clients every frame - lastID acks the newest full state they've got, for the server to delta against
 		struct ClientPacket : public GamePacket {
-			int		lastID;
-			char	buttonstates[8];
+			int		lastID			= -1;
+			char	buttonstates[8]	= {};
 
 			ClientPacket() {
-				size = sizeof(ClientPacket);
+				type = Received_State;
+				size = sizeof(ClientPacket) - sizeof(GamePacket);
 			}
 		};
 
-		class NetworkObject		{
+		class NetworkObject : public PooledComponent<NetworkObject>	{
 		public:
 			NetworkObject(GameObject& o, int id);
 			virtual ~NetworkObject();
 
 			//Called by clients
 			virtual bool ReadPacket(GamePacket& p);
-			//Called by servers
-			virtual bool WritePacket(GamePacket** p, bool deltaFrame, int stateID);
+			//Called by servers - adds this object's state to the snapshot being built
+			virtual bool WritePacket(SnapshotBuilder& snapshot, bool deltaFrame, int stateID);
+
+			int GetNetworkID() const {
+				return networkID;
+			}
+
+			// which object a Full_State or Delta_State packet is for, -1 for anything else (or if it's too short)
+			static int GetPacketObjectID(const GamePacket& p);
+
+			// if p is a Full_State or Delta_State, whether it's got all the bytes ReadPacket will read
+			static bool IsBigEnough(const GamePacket& p);
 
 			void UpdateStateHistory(int minID);
 
+			void SetQuantisation(const DeltaQuantisation& q) {
+				quantisation = q;
+			}
+
+			const DeltaQuantisation& GetQuantisation() const {
+				return quantisation;
+			}
+
+			const DeltaStats& GetDeltaStats() const {
+				return stats;
+			}
+
+			void ResetDeltaStats() {
+				stats = DeltaStats();
+			}
+
 		protected:
 
 			NetworkState& GetLatestNetworkState();
 
+			void AddStateHistory(const NetworkState& state);
+
 			bool GetNetworkState(int frameID, NetworkState& state);
 
 			virtual bool ReadDeltaPacket(DeltaPacket &p);
 			virtual bool ReadFullPacket(FullPacket &p);
 
-			virtual bool WriteDeltaPacket(GamePacket**p, int stateID);
-			virtual bool WriteFullPacket(GamePacket**p);
+			virtual bool WriteDeltaPacket(DeltaPacket& p, int stateID);
+			virtual bool WriteFullPacket(FullPacket& p, int tick);
 
 			GameObject& object;
 
 			NetworkState lastFullState;
+			uint32_t lastFullOrientation = 0;	// as it was sent, on the server
 
 			std::vector<NetworkState> stateHistory;
 
+			// only this many of the newest full states are kept for deltas to be based on
+			static const int MAX_STATE_HISTORY = 64;
+
+			DeltaQuantisation	quantisation;
+			DeltaStats			stats;
+
 			int deltaErrors;
 			int fullErrors;
 
@@ -2,7 +2,7 @@
 #include "CollisionVolume.h"
 #include "../../Common/Vector3.h"
 namespace NCL {
-	class OBBVolume : CollisionVolume
+	class OBBVolume : CollisionVolume, public CSC8503::PooledComponent<OBBVolume>
 	{
 	public:
 		OBBVolume(const Maths::Vector3& halfDims) {
@@ -0,0 +1,265 @@
+#pragma once
+#include "../../Common/Vector3.h"
+#include "CollisionDetection.h"
+#include "Debug.h"
+#include <list>
+#include <vector>
+#include <functional>
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		template<class T>
+		class Octree;
+
+		template<class T>
+		struct OctreeEntry {
+			Vector3 pos;
+			Vector3 size;
+			T object;
+
+			OctreeEntry(T obj, Vector3 pos, Vector3 size) {
+				object		= obj;
+				this->pos	= pos;
+				this->size	= size;
+			}
+		};
+
+		/*
+		A loose octree node. Each node's bounds are stretched to twice their normal size, so
+		an object only has to have its centre inside a node (and be no bigger than it) to fit.
+		That means every object lives in exactly one node - there's no copying objects into
+		every leaf they touch like the QuadTree does - but it also means objects can overlap
+		things stored in neighbouring nodes and further up the tree, not just in the same node.
+		*/
+		template<class T>
+		class OctreeNode	{
+		public:
+			typedef std::function<void(std::list<OctreeEntry<T>>&)> OctreeFunc;
+			typedef std::function<void(OctreeEntry<T>&)> OctreeEntryFunc;
+			typedef std::function<void(OctreeEntry<T>&, OctreeEntry<T>&)> OctreePairFunc;
+		protected:
+			friend class Octree<T>;
+
+			OctreeNode() {
+				children	= nullptr;
+				halfSize	= 0.0f;
+				totalCount	= 0;
+			}
+
+			OctreeNode(Vector3 pos, float halfSize) {
+				children		= nullptr;
+				this->position	= pos;
+				this->halfSize	= halfSize;
+				totalCount		= 0;
+			}
+
+			~OctreeNode() {
+				delete[] children;
+			}
+
+			// the loose bounds, which everything stored in or below this node fits inside
+			Vector3 LooseSize() const {
+				return Vector3(halfSize, halfSize, halfSize) * 2.0f;
+			}
+
+			// which child an object would fit in, or -1 if it has to stay in this node
+			int ChildIndex(const Vector3& objectPos, const Vector3& objectSize) const {
+				float childHalf = halfSize * 0.5f;
+				if (objectSize.x > childHalf || objectSize.y > childHalf || objectSize.z > childHalf)
+					return -1;
+				int index = (objectPos.x >= position.x ? 1 : 0) | (objectPos.y >= position.y ? 2 : 0) | (objectPos.z >= position.z ? 4 : 0);
+				// the centre must be inside the child's tight bounds - it might not be if it's outside the root
+				Vector3 offset = objectPos - ChildPosition(index);
+				if (abs(offset.x) > childHalf || abs(offset.y) > childHalf || abs(offset.z) > childHalf)
+					return -1;
+				return index;
+			}
+
+			Vector3 ChildPosition(int index) const {
+				float childHalf = halfSize * 0.5f;
+				return position + Vector3(	index & 1 ? childHalf : -childHalf,
+											index & 2 ? childHalf : -childHalf,
+											index & 4 ? childHalf : -childHalf);
+			}
+
+			void Insert(const OctreeEntry<T>& entry, int depthLeft, int maxSize) {
+				totalCount++;
+				if (children) {
+					int child = ChildIndex(entry.pos, entry.size);
+					if (child >= 0) {
+						children[child].Insert(entry, depthLeft - 1, maxSize);
+						return;
+					}
+				}
+				contents.push_back(entry);
+				if (!children && (int)contents.size() > maxSize && depthLeft > 0) {
+					Split();
+					// push down anything that fits in a child, the rest stays here
+					for (auto i = contents.begin(); i != contents.end(); ) {
+						int child = ChildIndex(i->pos, i->size);
+						if (child >= 0) {
+							children[child].Insert(*i, depthLeft - 1, maxSize);
+							i = contents.erase(i);
+						}
+						else {
+							++i;
+						}
+					}
+				}
+			}
+
+			// follows the same path Insert would, so only visits one node per level
+			bool Remove(const T& object, const Vector3& objectPos, const Vector3& objectSize) {
+				bool removed = false;
+				for (auto i = contents.begin(); i != contents.end(); ++i) {
+					if (i->object == object) {
+						contents.erase(i);
+						removed = true;
+						break;
+					}
+				}
+				if (!removed && children) {
+					int child = ChildIndex(objectPos, objectSize);
+					if (child >= 0)
+						removed = children[child].Remove(object, objectPos, objectSize);
+				}
+				if (removed) {
+					totalCount--;
+					// nothing left below us, so merge the children back into this node
+					if (children && totalCount == (int)contents.size()) {
+						delete[] children;
+						children = nullptr;
+					}
+				}
+				return removed;
+			}
+
+			void Split() {
+				children = new OctreeNode<T>[8];
+				for (int i = 0; i < 8; ++i) {
+					children[i].position = ChildPosition(i);
+					children[i].halfSize = halfSize * 0.5f;
+				}
+			}
+
+			void DebugDraw() {
+			}
+
+			void OperateOnContents(OctreeFunc& func) {
+				if (!contents.empty())
+					func(contents);
+				if (children)
+					for (int i = 0; i < 8; ++i)
+						if (children[i].totalCount > 0)
+							children[i].OperateOnContents(func);
+			}
+
+			/*
+			Calls func once for every pair of entries whose AABBs overlap. As loose bounds overlap
+			their neighbours, an entry can touch things in sibling nodes as well as in the nodes
+			above it, so each entry searches the tree from the root. Each pair will be found from
+			both sides, so we only keep the one where the first entry has the lower address.
+			*/
+			void OperateOnPairs(OctreePairFunc& func, OctreeNode<T>& root) {
+				for (auto& i : contents) {
+					OctreeEntryFunc test = [&](OctreeEntry<T>& other) {
+						if (&i < &other)
+							func(i, other);
+					};
+					root.OperateOnOverlapping(i.pos, i.size, test);
+				}
+				if (children)
+					for (int i = 0; i < 8; ++i)
+						if (children[i].totalCount > 0)
+							children[i].OperateOnPairs(func, root);
+			}
+
+			/*
+			A node's own entries are always tested, and its bounds are only used to decide whether
+			to go down into it. Anything that's left the world's bounds is kept in the root, so
+			the root has to be searched whatever the query is - every other node's entries are
+			inside its loose bounds anyway.
+			*/
+			void OperateOnOverlapping(const Vector3& objectPos, const Vector3& objectSize, OctreeEntryFunc& func) {
+				for (auto& i : contents)
+					if (CollisionDetection::AABBTest(objectPos, i.pos, objectSize, i.size))
+						func(i);
+				if (children)
+					for (int i = 0; i < 8; ++i)
+						if (children[i].totalCount > 0 && CollisionDetection::AABBTest(objectPos, children[i].position, objectSize, children[i].LooseSize()))
+							children[i].OperateOnOverlapping(objectPos, objectSize, func);
+			}
+
+		protected:
+			std::list< OctreeEntry<T> >	contents;
+
+			Vector3 position;
+			float	halfSize;
+			int		totalCount;	// entries in this node and everything below it
+
+			OctreeNode<T>* children;
+		};
+	}
+}
+
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		template<class T>
+		class Octree
+		{
+		public:
+			Octree(float halfSize, int maxDepth = 6, int maxSize = 5){
+				root = OctreeNode<T>(Vector3(), halfSize);
+				this->maxDepth	= maxDepth;
+				this->maxSize	= maxSize;
+			}
+			~Octree() {
+			}
+
+			void Insert(T object, const Vector3& pos, const Vector3& size) {
+				root.Insert(OctreeEntry<T>(object, pos, size), maxDepth, maxSize);
+			}
+
+			// pos and size must be what the object was inserted with
+			bool Remove(T object, const Vector3& pos, const Vector3& size) {
+				return root.Remove(object, pos, size);
+			}
+
+			void DebugDraw() {
+				root.DebugDraw();
+			}
+
+			// each node's own contents - objects in different nodes can still overlap, so use OperateOnPairs for collisions
+			void OperateOnContents(typename OctreeNode<T>::OctreeFunc func) {
+				root.OperateOnContents(func);
+			}
+
+			void OperateOnPairs(typename OctreeNode<T>::OctreePairFunc func) {
+				root.OperateOnPairs(func, root);
+			}
+
+			// unlike the QuadTree, each entry is only ever visited once
+			void OperateOnOverlapping(const Vector3& pos, const Vector3& size, typename OctreeNode<T>::OctreeEntryFunc func) {
+				root.OperateOnOverlapping(pos, size, func);
+			}
+
+			void QueryAABB(const Vector3& pos, const Vector3& size, std::vector<T>& results) {
+				OperateOnOverlapping(pos, size, [&](OctreeEntry<T>& entry) {
+					results.emplace_back(entry.object);
+				});
+			}
+
+			int Count() const {
+				return root.totalCount;
+			}
+
+		protected:
+			OctreeNode<T> root;
+			int maxDepth;
+			int maxSize;
+		};
+	}
+}
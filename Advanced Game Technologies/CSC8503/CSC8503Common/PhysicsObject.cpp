@@ -1,6 +1,8 @@
 #include "PhysicsObject.h"
 #include "PhysicsSystem.h"
 #include "../CSC8503Common/Transform.h"
+#include <iostream>
+#include <algorithm>
 using namespace NCL;
 using namespace CSC8503;
 
@@ -8,6 +10,11 @@ PhysicsObject::PhysicsObject(Transform* parentTransform, const CollisionVolume*
 	transform	= parentTransform;
 	volume		= parentVolume;
 	collisionType = CollisionType::DEFAULT;
+	bodyType	= BodyType::DYNAMIC;
+	hasKinematicTarget = false;
+	kinematicDuration = 0.0f;
+	kinematicTimeLeft = 0.0f;
+	commandQueue = nullptr;
 
 	inverseMass = 1.0f;
 	elasticity	= 0.8f;
@@ -30,11 +37,51 @@ void PhysicsObject::ApplyLinearImpulse(const Vector3& force) {
 	linearVelocity += force * inverseMass;
 }
 
+void PhysicsObject::SetInverseMass(float invMass) {
+	if (QueueCommand(PhysicsCommandType::SET_INVERSE_MASS, Vector3(), Vector3(), Quaternion(), invMass))
+		return;
+	inverseMass = invMass;
+}
+
+void PhysicsObject::SetLinearVelocity(const Vector3& v) {
+	if (QueueCommand(PhysicsCommandType::SET_LINEAR_VELOCITY, v))
+		return;
+	linearVelocity = v;
+}
+
+void PhysicsObject::SetAngularVelocity(const Vector3& v) {
+	if (QueueCommand(PhysicsCommandType::SET_ANGULAR_VELOCITY, v))
+		return;
+	angularVelocity = v;
+}
+
+void PhysicsObject::SetElasticity(float elasticity) {
+	if (QueueCommand(PhysicsCommandType::SET_ELASTICITY, Vector3(), Vector3(), Quaternion(), elasticity))
+		return;
+	this->elasticity = elasticity;
+}
+
+void PhysicsObject::SetCollisionType(const CollisionType collisionType) {
+	if (QueueCommand(PhysicsCommandType::SET_COLLISION_TYPE, Vector3(), Vector3(), Quaternion(), (float)collisionType))
+		return;
+	this->collisionType = collisionType;
+}
+
+void PhysicsObject::SetUseGravity(bool state) {
+	if (QueueCommand(PhysicsCommandType::SET_USE_GRAVITY, Vector3(), Vector3(), Quaternion(), state ? 1.0f : 0.0f))
+		return;
+	useGravity = state;
+}
+
 void PhysicsObject::AddForce(const Vector3& addedForce) {
+	if (QueueCommand(PhysicsCommandType::ADD_FORCE, addedForce))
+		return;
 	force += addedForce;
 }
 
 void PhysicsObject::AddForceAtPosition(const Vector3& addedForce, const Vector3& position) {
+	if (QueueCommand(PhysicsCommandType::ADD_FORCE_AT_POSITION, addedForce, position))
+		return;
 	Vector3 localPos = position - transform->GetWorldPosition();
 
 	force  += addedForce;
@@ -42,6 +89,8 @@ void PhysicsObject::AddForceAtPosition(const Vector3& addedForce, const Vector3&
 }
 
 void PhysicsObject::AddTorque(const Vector3& addedTorque) {
+	if (QueueCommand(PhysicsCommandType::ADD_TORQUE, addedTorque))
+		return;
 	torque += addedTorque;
 }
 
@@ -50,6 +99,88 @@ void PhysicsObject::ClearForces() {
 	torque				= Vector3();
 }
 
+void PhysicsObject::SetKinematicTarget(const Vector3& position, const Quaternion& orientation, float duration) {
+	if (QueueCommand(PhysicsCommandType::SET_KINEMATIC_TARGET, Vector3(), position, orientation, duration))
+		return;
+	kinematicPosition		= position;
+	kinematicOrientation	= orientation;
+	kinematicDuration		= duration;
+	hasKinematicTarget		= true;
+}
+
+/*
+Gives the target to head for over this step of length dt, and the time left to reach it in.
+A new target restarts the clock, so a target set once per game frame is spread over all the
+physics steps that run before the next one arrives. Returns false once the time is used up.
+*/
+bool PhysicsObject::ConsumeKinematicTarget(float dt, Vector3& position, Quaternion& orientation, float& time) {
+	if (hasKinematicTarget) {
+		kinematicTimeLeft	= kinematicDuration;
+		hasKinematicTarget	= false;
+	}
+	if (kinematicTimeLeft <= 0.0f)
+		return false;
+	position			= kinematicPosition;
+	orientation			= kinematicOrientation;
+	time				= std::max(kinematicTimeLeft, dt);	// never overshoot on a step longer than what's left
+	kinematicTimeLeft	-= dt;
+	return true;
+}
+
+// returns true if the change was queued for the physics thread, rather than needing applying now
+bool PhysicsObject::QueueCommand(PhysicsCommandType type, const Vector3& vector, const Vector3& position,
+	const Quaternion& orientation, float value) {
+	if (!commandQueue)
+		return false;
+	PhysicsCommand command;
+	command.type		= type;
+	command.object		= this;
+	command.vector		= vector;
+	command.position	= position;
+	command.orientation = orientation;
+	command.value		= value;
+	// the physics thread empties the queue every step, so it's never a long wait
+	if (!commandQueue->PushOrWait(command))
+		std::cout << "Physics command queue was full, had to wait for the physics thread" << std::endl;
+	return true;
+}
+
+// called on the physics thread, so writes directly rather than queueing again
+void PhysicsObject::ApplyCommand(const PhysicsCommand& command) {
+	switch (command.type) {
+	case PhysicsCommandType::ADD_FORCE:
+		force += command.vector; break;
+	case PhysicsCommandType::ADD_FORCE_AT_POSITION:
+		force	+= command.vector;
+		torque	+= Vector3::Cross(command.position - transform->GetWorldPosition(), command.vector);
+		break;
+	case PhysicsCommandType::ADD_TORQUE:
+		torque += command.vector; break;
+	case PhysicsCommandType::SET_INVERSE_MASS:
+		inverseMass = command.value; break;
+	case PhysicsCommandType::SET_KINEMATIC_TARGET:
+		kinematicPosition		= command.position;
+		kinematicOrientation	= command.orientation;
+		kinematicDuration		= command.value;
+		hasKinematicTarget		= true;
+		break;
+	case PhysicsCommandType::SET_POSITION:
+		transform->SetWorldPosition(command.position); break;
+	case PhysicsCommandType::SET_ORIENTATION:
+		transform->SetLocalOrientation(command.orientation); break;
+	case PhysicsCommandType::SET_LINEAR_VELOCITY:
+		linearVelocity = command.vector; break;
+	case PhysicsCommandType::SET_ANGULAR_VELOCITY:
+		angularVelocity = command.vector; break;
+	case PhysicsCommandType::SET_ELASTICITY:
+		elasticity = command.value; break;
+	case PhysicsCommandType::SET_USE_GRAVITY:
+		useGravity = command.value != 0.0f; break;
+	case PhysicsCommandType::SET_COLLISION_TYPE:
+		collisionType = (CollisionType)(int)command.value; break;
+	}
+}
+
 void PhysicsObject::InitCubeInertia() {
 	Vector3 dimensions	= transform->GetLocalScale();
 
@@ -1,6 +1,9 @@
 #pragma once
 #include "../../Common/Vector3.h"
 #include "../../Common/Matrix3.h"
+#include "../../Common/Quaternion.h"
+#include "LockFreeQueue.h"
+#include "ComponentPool.h"
 
 using namespace NCL::Maths;
 
@@ -9,6 +12,7 @@ namespace NCL {
 	
 	namespace CSC8503 {
 		class Transform;
+		class PhysicsObject;
 
 		enum class CollisionType {
 			DEFAULT,
@@ -24,7 +28,43 @@ namespace NCL {
 			NONE
 		};
 
-		class PhysicsObject	{
+		// static bodies never move, kinematic bodies are moved to a target transform by game code,
+		// and only dynamic bodies are integrated from forces and respond to collisions
+		enum class BodyType {
+			STATIC,
+			KINEMATIC,
+			DYNAMIC
+		};
+
+		enum class PhysicsCommandType {
+			ADD_FORCE,
+			ADD_FORCE_AT_POSITION,
+			ADD_TORQUE,
+			SET_INVERSE_MASS,
+			SET_KINEMATIC_TARGET,
+			SET_POSITION,
+			SET_ORIENTATION,
+			SET_LINEAR_VELOCITY,
+			SET_ANGULAR_VELOCITY,
+			SET_ELASTICITY,
+			SET_USE_GRAVITY,
+			SET_COLLISION_TYPE
+		};
+
+		// changes made by game code while physics is running on its own thread
+		struct PhysicsCommand {
+			PhysicsCommandType	type;
+			PhysicsObject*		object;
+			Vector3				vector;
+			Vector3				position;
+			Quaternion			orientation;
+			float				value;		// also carries bools and CollisionTypes
+		};
+
+		typedef LockFreeQueue<PhysicsCommand, 4096> PhysicsCommandQueue;
+
+		class PhysicsObject : public PooledComponent<PhysicsObject>	{
+			friend class PhysicsSystem;	// its own writes on the physics thread mustn't be queued
 		public:
 			PhysicsObject(Transform* parentTransform, const CollisionVolume* parentVolume);
 			~PhysicsObject();
@@ -45,9 +85,7 @@ namespace NCL {
 				return force;
 			}
 
-			void SetInverseMass(float invMass) {
-				inverseMass = invMass;
-			}
+			void SetInverseMass(float invMass);
 
 			float GetInverseMass() const {
 				return inverseMass;
@@ -64,13 +102,8 @@ namespace NCL {
 
 			void ClearForces();
 
-			void SetLinearVelocity(const Vector3& v) {
-				linearVelocity = v;
-			}
-
-			void SetAngularVelocity(const Vector3& v) {
-				angularVelocity = v;
-			}
+			void SetLinearVelocity(const Vector3& v);
+			void SetAngularVelocity(const Vector3& v);
 
 			void InitCubeInertia();
 			void InitSphereInertia();
@@ -78,19 +111,45 @@ namespace NCL {
 
 			void UpdateInertiaTensor();
 
+			// for copying an object's inertia exactly, rather than working it out from its shape again
+			Vector3 GetInverseInertia() const {
+				return inverseInertia;
+			}
+
+			void SetInverseInertia(const Vector3& i) {
+				inverseInertia = i;
+			}
+
 			Matrix3 GetInertiaTensor() const {
 				return inverseInteriaTensor;
 			}
 
-			void SetElasticity(float elasticity) { this->elasticity = elasticity; }
+			void SetElasticity(float elasticity);
 			float GetElasticity() const { return elasticity; }
 
-			void SetCollisionType(const CollisionType collisionType) { this->collisionType = collisionType; }
+			void SetCollisionType(const CollisionType collisionType);
 			CollisionType GetCollisionType() const { return collisionType; }
 
-			void SetUseGravity(bool state) { useGravity = state; }
+			void SetUseGravity(bool state);
 			bool UseGravity() const { return useGravity; }
 
+			// body type should be set before the object is added to the world
+			void SetBodyType(const BodyType bodyType) { this->bodyType = bodyType; }
+			BodyType GetBodyType() const { return bodyType; }
+			bool IsDynamic() const { return bodyType == BodyType::DYNAMIC; }
+
+			// kinematic bodies move to this transform over the given time, however many physics steps that takes
+			void SetKinematicTarget(const Vector3& position, const Quaternion& orientation, float duration);
+			bool ConsumeKinematicTarget(float dt, Vector3& position, Quaternion& orientation, float& time);
+
+			// the transform physics reads and writes, which is a private copy while physics is threaded
+			Transform* GetTransform() const { return transform; }
+			void SetTransform(Transform* newTransform) { transform = newTransform; }
+
+			// while set, force, mass and target changes are queued for the physics thread instead of applied
+			void SetCommandQueue(PhysicsCommandQueue* queue) { commandQueue = queue; }
+			void ApplyCommand(const PhysicsCommand& command);
+
 		protected:
 			const CollisionVolume* volume;
 			Transform*		transform;
@@ -111,8 +170,20 @@ namespace NCL {
 			Matrix3 inverseInteriaTensor;
 
 			CollisionType collisionType;
+			BodyType bodyType;
+
+			Vector3 kinematicPosition;
+			Quaternion kinematicOrientation;
+			float kinematicDuration;
+			float kinematicTimeLeft;
+			bool hasKinematicTarget;
 
 			bool useGravity;
+
+			PhysicsCommandQueue* commandQueue;
+
+			bool QueueCommand(PhysicsCommandType type, const Vector3& vector = Vector3(), const Vector3& position = Vector3(),
+				const Quaternion& orientation = Quaternion(), float value = 0.0f);
 		};
 	}
 }
@@ -2,6 +2,7 @@
 #include "PhysicsObject.h"
 #include "GameObject.h"
 #include "CollisionDetection.h"
+#include "BatchCollision.h"
 #include "../../Common/Quaternion.h"
 
 #include "Constraint.h"
@@ -9,6 +10,8 @@
 #include "Debug.h"
 
 #include <functional>
+#include <chrono>
+#include <algorithm>
 using namespace NCL;
 using namespace CSC8503;
 
@@ -19,9 +22,17 @@ PhysicsSystem::PhysicsSystem(GameWorld& g) : gameWorld(g)	{
 	globalDamping	= 0.95f;
 	// gravity * 10 as an easy way to reduce 'floaty' feeling throughout the game
 	SetGravity(Vector3(0.0f, -9.8f * 10.0f, 0.0f));
+
+	removalCallback		= gameWorld.AddRemovalCallback([&](GameObject* o) { OnObjectRemoved(o); });
+	additionCallback	= gameWorld.AddAdditionCallback([&](GameObject* o) { OnObjectAdded(o); });
 }
 
 PhysicsSystem::~PhysicsSystem()	{
+	StopThread();
+	gameWorld.RemoveRemovalCallback(removalCallback);
+	gameWorld.RemoveAdditionCallback(additionCallback);
+	delete staticTree;
+	delete staticOctree;
 }
 
 void PhysicsSystem::SetGravity(const Vector3& g) {
@@ -41,14 +52,246 @@ any collisions they are in.
 void PhysicsSystem::Clear() {
 	allCollisions.clear();
 	broadphaseCollisions.clear();
+
+	staticBodies.clear();
+	kinematicBodies.clear();
+	dynamicBodies.clear();
+	kinematicObjects.clear();
+	dynamicObjects.clear();
+	addedBodies.clear();
+	staticEntries.clear();
+	delete staticTree;
+	delete staticOctree;
+	staticTree		= nullptr;
+	staticOctree	= nullptr;
+	lastWorldState	= -1;
 }
 
 /*
 
-This is the core of the physics engine update
+Objects are sorted by their body type so that each stage of the update only
+looks at the objects it needs to. Static objects are never integrated and only
+live in their own tree - so static objects should not be moved once they've been
+added to the world!
+
+Objects joining and leaving the world are sorted in and out of the lists one at a
+time, statics included, so everything is only rebuilt from scratch if the world
+changes in a way we haven't been told about (being cleared, say, or switching
+broadphase structure). Objects that join are held back until the next update, as
+their transforms might not have been updated yet.
+
+*/
+void PhysicsSystem::UpdateBodyLists() {
+	if (lastWorldState == gameWorld.GetWorldStateCounter()) {
+		for (GameObject* i : addedBodies) {
+			AddBody(i);
+		}
+		addedBodies.clear();
+		return;
+	}
+	lastWorldState = gameWorld.GetWorldStateCounter();
+	addedBodies.clear();
+
+	staticBodies.clear();
+	kinematicBodies.clear();
+	dynamicBodies.clear();
+	kinematicObjects.clear();
+	dynamicObjects.clear();
+	staticEntries.clear();
+
+	broadphaseStructure = gameWorld.GetBroadphaseStructure();
+
+	delete staticTree;
+	delete staticOctree;
+	staticTree		= nullptr;
+	staticOctree	= nullptr;
+	if (broadphaseStructure == BroadphaseStructure::OCTREE)
+		staticOctree = new Octree<GameObject*>(1024.0f, 7, 6);
+	else
+		staticTree = new QuadTree<GameObject*>(Vector2(1024, 1024), 7, 6);
+
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	gameWorld.GetObjectIterators(first, last);
+
+	for (auto i = first; i != last; ++i) {
+		AddBody(*i);
+	}
+}
+
+void PhysicsSystem::AddBody(GameObject* body) {
+	PhysicsObject* object = body->GetPhysicsObject();
+	if (object == nullptr)
+		return;
+
+	switch (object->GetBodyType()) {
+	case BodyType::STATIC: {
+		staticBodies.emplace_back(body);
+
+		body->UpdateBroadphaseAABB();
+		StaticEntry entry;
+		if (!body->GetBroadphaseAABB(entry.size))
+			break;
+		entry.pos = body->GetConstPhysicsTransform().GetWorldPosition();
+		if (staticOctree)
+			staticOctree->Insert(body, entry.pos, entry.size);
+		else
+			entry.handle = staticTree->Insert(body, entry.pos, entry.size);
+		staticEntries[body] = entry;
+		break;
+	}
+	case BodyType::KINEMATIC:
+		kinematicBodies.emplace_back(body);
+		kinematicObjects.emplace_back(object);
+		break;
+	default:
+		dynamicBodies.emplace_back(body);
+		dynamicObjects.emplace_back(object);
+	}
+}
+
+void PhysicsSystem::RemoveBody(GameObject* body) {
+	auto removeFrom = [&](std::vector<GameObject*>& bodies, std::vector<PhysicsObject*>& objects) {
+		auto i = std::find(bodies.begin(), bodies.end(), body);
+		if (i == bodies.end())
+			return false;
+		size_t index = i - bodies.begin();
+		bodies[index]	= bodies.back();
+		objects[index]	= objects.back();
+		bodies.pop_back();
+		objects.pop_back();
+		return true;
+	};
+	if (removeFrom(dynamicBodies, dynamicObjects) || removeFrom(kinematicBodies, kinematicObjects))
+		return;
+
+	auto i = std::find(staticBodies.begin(), staticBodies.end(), body);
+	if (i == staticBodies.end())
+		return;
+	*i = staticBodies.back();
+	staticBodies.pop_back();
+
+	auto entry = staticEntries.find(body);
+	if (entry == staticEntries.end())
+		return;
+	if (staticOctree)
+		staticOctree->Remove(body, entry->second.pos, entry->second.size);
+	else
+		staticTree->Remove(entry->second.handle);
+	staticEntries.erase(entry);
+}
+
+void PhysicsSystem::OnObjectAdded(GameObject* object) {
+	// the world's counter has already gone up for this addition - if we were up to date
+	// before it, we will be again once the body's been sorted in
+	if (lastWorldState != gameWorld.GetWorldStateCounter() - 1)
+		return;
+	lastWorldState = gameWorld.GetWorldStateCounter();
+	if (object->GetPhysicsObject())
+		addedBodies.emplace_back(object);
+}
+
+/*
+
+Removed bodies are just taken out of their list (and statics out of the static tree),
+and any collisions they were part of are ended.
+
+*/
+void PhysicsSystem::OnObjectRemoved(GameObject* object) {
+	// the physics thread might be halfway through using it
+	if (threaded) {
+		StopThread();
+		resumeThread = true;
+	}
+
+	for (auto i = allCollisions.begin(); i != allCollisions.end(); ) {
+		if (i->a == object || i->b == object) {
+			GameObject* other = i->a == object ? i->b : i->a;
+			ReportCollisionEnd(*other, *object);
+			i = allCollisions.erase(i);
+		}
+		else {
+			++i;
+		}
+	}
+	for (auto i = broadphaseCollisions.begin(); i != broadphaseCollisions.end(); ) {
+		if (i->a == object || i->b == object)
+			i = broadphaseCollisions.erase(i);
+		else
+			++i;
+	}
+
+	// the world's counter has already gone up for this removal
+	if (lastWorldState != gameWorld.GetWorldStateCounter() - 1)
+		return;
+	lastWorldState = gameWorld.GetWorldStateCounter();
+
+	auto added = std::find(addedBodies.begin(), addedBodies.end(), object);
+	if (added != addedBodies.end())
+		addedBodies.erase(added);
+	else
+		RemoveBody(object);
+}
+
+/*
+
+Kinematic bodies aren't moved by forces, instead they're given a target transform
+and a time to reach it in by the game, and we work out the velocity needed to get
+there by the end of that time. When threaded, a game frame's target can cover a few
+physics steps, so it's used until the time runs out rather than just once. That
+velocity is then used when resolving collisions against dynamic bodies, so anything
+touching a moving block gets pushed along with it.
+
+*/
+void PhysicsSystem::UpdateKinematicBodies(float dt) {
+	for (PhysicsObject* object : kinematicObjects) {
+		Transform& transform = *object->GetTransform();
+
+		Vector3 targetPos;
+		Quaternion targetOrientation;
+		float time;
+		if (dt <= 0.0f || !object->ConsumeKinematicTarget(dt, targetPos, targetOrientation, time)) {
+			object->linearVelocity = Vector3();
+			object->angularVelocity = Vector3();
+			continue;
+		}
+		object->linearVelocity = (targetPos - transform.GetWorldPosition()) / time;
+
+		// small angle approximation, matching how IntegrateVelocity applies angular velocity
+		Quaternion delta = targetOrientation * transform.GetLocalOrientation().Conjugate();
+		if (delta.w < 0.0f)
+			delta = -delta;
+		object->angularVelocity = Vector3(delta.x, delta.y, delta.z) * (2.0f / time);
+	}
+}
+
+/*
+
+This is the core of the physics engine update. When physics is threaded, the
+actual update happens in UpdateStep on the physics thread, and all the main
+thread needs to do is pick up the results.
 
 */
 void PhysicsSystem::Update(float dt) {
+	if (resumeThread) {
+		resumeThread = false;
+		StartThread(threadRate);
+	}
+	if (!threaded) {
+		UpdateStep(dt);
+		return;
+	}
+	// objects have been added or removed, so start the thread again with the new list
+	if (lastWorldState != gameWorld.GetWorldStateCounter() || !addedBodies.empty()) {
+		float rate = threadRate;
+		StopThread();
+		StartThread(rate);
+	}
+	ReadSnapshot();
+	DispatchEvents();
+}
+
+void PhysicsSystem::UpdateStep(float dt) {
 	GameTimer testTimer;
 	testTimer.GetTimeDeltaSeconds();
 
@@ -77,10 +320,22 @@ void PhysicsSystem::Update(float dt) {
 	int constraintIterationCount = 10;
 	iterationDt = dt;
 
+	if (threaded) {
+		for (Transform& i : physicsTransforms) {
+			i.UpdateMatrices();
+		}
+	}
+	else {
+		UpdateBodyLists();
+	}
+	UpdateKinematicBodies(dt);
+
 	if (useBroadPhase) {
 		UpdateObjectAABBs();
 	}
 
+	stepDt = iterationDt;
+
 	while(dTOffset > iterationDt *0.5) {
 		IntegrateAccel(iterationDt); //Update accelerations from external forces
 		if (useBroadPhase) {
@@ -126,13 +381,13 @@ rocket launcher, gaining a point when the player hits the gold coin, and so on).
 void PhysicsSystem::UpdateCollisionList() {
 	for (std::set<CollisionDetection::CollisionInfo>::iterator i = allCollisions.begin(); i != allCollisions.end(); ) {
 		if ((*i).framesLeft == numCollisionFrames) {
-			i->a->OnCollisionBegin(i->b);
-			i->b->OnCollisionBegin(i->a);
+			ReportCollisionBegin(*i->a, *i->b);
+			ReportCollisionBegin(*i->b, *i->a);
 		}
 		(*i).framesLeft = (*i).framesLeft - 1;
 		if ((*i).framesLeft < 0) {
-			i->a->OnCollisionEnd(i->b);
-			i->b->OnCollisionEnd(i->a);
+			ReportCollisionEnd(*i->a, *i->b);
+			ReportCollisionEnd(*i->b, *i->a);
 			i = allCollisions.erase(i);
 		}
 		else {
@@ -141,14 +396,25 @@ void PhysicsSystem::UpdateCollisionList() {
 	}
 }
 
+/*
+Static AABBs are worked out when the static tree is built. Each object's AABB only
+depends on that object, so they can be worked out on the world's worker threads -
+unless physics has its own thread, as the game thread might be using the workers.
+The physics thread keeps its AABBs to itself rather than writing to the GameObjects.
+*/
 void PhysicsSystem::UpdateObjectAABBs() {
-	std::vector<GameObject*>::const_iterator first;
-	std::vector<GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
-
-	for (auto i = first; i != last; ++i) {
-		(*i)->UpdateBroadphaseAABB();
+	if (threaded) {
+		// moving bodies come after the statics in threadBodies
+		for (size_t i = staticBodies.size(); i < threadBodies.size(); ++i) {
+			threadBodies[i]->GetAABB(physicsTransforms[i], physicsAABBs[i]);
+		}
+		return;
 	}
+	auto update = [](GameObject* i) {
+		i->UpdateBroadphaseAABB();
+	};
+	gameWorld.ParallelForEach(kinematicBodies.begin(), kinematicBodies.end(), update);
+	gameWorld.ParallelForEach(dynamicBodies.begin(), dynamicBodies.end(), update);
 }
 
 /*
@@ -172,13 +438,16 @@ void PhysicsSystem::BasicCollisionDetection() {
 		for (auto j = i + 1; j != last; ++j) {
 			if ((*j)->GetPhysicsObject() == nullptr)
 				continue;
+			// as with the broadphase, kinematic bodies still need to know when they hit static ones
+			BodyType typeI = (*i)->GetPhysicsObject()->GetBodyType();
+			BodyType typeJ = (*j)->GetPhysicsObject()->GetBodyType();
+			if (typeI != BodyType::DYNAMIC && typeJ != BodyType::DYNAMIC && typeI == typeJ)
+				continue;
 
 			CollisionDetection::CollisionInfo info;
 			if (CollisionDetection::ObjectIntersection(*i, *j, info)) {
 				std::cout << "Collision between " << (*i)->GetName() << " and " << (*j)->GetName() << std::endl;
-				info.framesLeft = numCollisionFrames;
-				ImpulseResolveCollision(*info.a, *info.b, info.point);
-				allCollisions.insert(info);
+				ResolveNarrowPhaseCollision(info);
 			}
 		}
 	}
@@ -194,18 +463,36 @@ void PhysicsSystem::ImpulseResolveCollision(GameObject& a, GameObject& b, Collis
 	PhysicsObject* physA = a.GetPhysicsObject();
 	PhysicsObject* physB = b.GetPhysicsObject();
 
-	Transform& transformA = a.GetTransform();
-	Transform& transformB = b.GetTransform();
+	Transform& transformA = a.GetPhysicsTransform();
+	Transform& transformB = b.GetPhysicsTransform();
 
-	float totalMass = physA->GetInverseMass() + physB->GetInverseMass();
+	// speculative contacts have a negative penetration - the objects aren't touching yet
+	bool speculative = p.penetration < 0.0f;
 
-	// added later
-	if (totalMass == 0.0f)
+	// static and kinematic bodies act as if they have infinite mass
+	float inverseMassA = physA->IsDynamic() ? physA->GetInverseMass() : 0.0f;
+	float inverseMassB = physB->IsDynamic() ? physB->GetInverseMass() : 0.0f;
+
+	float totalMass = inverseMassA + inverseMassB;
+
+	// nothing else will push a kinematic body back out of a static one, so it's moved out
+	// here, and stopped going any further in until its next target - otherwise it's still
+	// in the wall next step, and turns around again
+	if (totalMass == 0.0f) {
+		if (!speculative) {
+			if (physA->GetBodyType() == BodyType::KINEMATIC && physB->GetBodyType() == BodyType::STATIC)
+				PushKinematicOut(*physA, transformA, p.normal, p.penetration);
+			else if (physA->GetBodyType() == BodyType::STATIC && physB->GetBodyType() == BodyType::KINEMATIC)
+				PushKinematicOut(*physB, transformB, -p.normal, p.penetration);
+		}
 		return;
+	}
 
 	// separate using projection
-	transformA.SetWorldPosition(transformA.GetWorldPosition() - (p.normal * p.penetration * (physA->GetInverseMass() / totalMass)));
-	transformB.SetWorldPosition(transformB.GetWorldPosition() + (p.normal * p.penetration * (physB->GetInverseMass() / totalMass)));
+	if (!speculative) {
+		transformA.SetWorldPosition(transformA.GetWorldPosition() - (p.normal * p.penetration * (inverseMassA / totalMass)));
+		transformB.SetWorldPosition(transformB.GetWorldPosition() + (p.normal * p.penetration * (inverseMassB / totalMass)));
+	}
 
 	Vector3 relativeA = p.localA;
 	Vector3 relativeB = p.localB;
@@ -220,38 +507,115 @@ void PhysicsSystem::ImpulseResolveCollision(GameObject& a, GameObject& b, Collis
 
 	float impulseForce = Vector3::Dot(contactVelocity, p.normal);
 
+	// the objects can still close the gap between them this step, just not go any further
+	if (speculative)
+		impulseForce += -p.penetration / stepDt;
+
 	// added later
 	if (impulseForce > 0)
 		return;
 
 	// work out inertia
-	Vector3 inertiaA = Vector3::Cross(physA->GetInertiaTensor() * Vector3::Cross(relativeA, p.normal), relativeA);
-	Vector3 inertiaB = Vector3::Cross(physB->GetInertiaTensor() * Vector3::Cross(relativeB, p.normal), relativeB);
+	Vector3 inertiaA = physA->IsDynamic() ? Vector3::Cross(physA->GetInertiaTensor() * Vector3::Cross(relativeA, p.normal), relativeA) : Vector3();
+	Vector3 inertiaB = physB->IsDynamic() ? Vector3::Cross(physB->GetInertiaTensor() * Vector3::Cross(relativeB, p.normal), relativeB) : Vector3();
 
 	float angularEffect = Vector3::Dot(inertiaA + inertiaB, p.normal);
 	
 	// disperse some kinetic energy
 	//float cRestitution = 0.66f;
-	float cRestitution = physA->GetElasticity() * physB->GetElasticity();
+	float cRestitution = speculative ? 0.0f : physA->GetElasticity() * physB->GetElasticity();
 
 
 	float j = (-(1.0f + cRestitution) * impulseForce) / (totalMass + angularEffect);
 
 	Vector3 fullImpulse = p.normal * j;
 
-	physA->ApplyLinearImpulse(-fullImpulse);
-	physB->ApplyLinearImpulse(fullImpulse);
+	if (physA->IsDynamic()) {
+		physA->ApplyLinearImpulse(-fullImpulse);
+		physA->ApplyAngularImpulse(Vector3::Cross(relativeA, -fullImpulse));
+	}
+	if (physB->IsDynamic()) {
+		physB->ApplyLinearImpulse(fullImpulse);
+		physB->ApplyAngularImpulse(Vector3::Cross(relativeB, fullImpulse));
+	}
+}
+
+// normal points from the kinematic body into the static one
+void PhysicsSystem::PushKinematicOut(PhysicsObject& object, Transform& transform, const Vector3& normal, float penetration) {
+	transform.SetWorldPosition(transform.GetWorldPosition() - (normal * penetration));
 
-	physA->ApplyAngularImpulse(Vector3::Cross(relativeA, -fullImpulse));
-	physB->ApplyAngularImpulse(Vector3::Cross(relativeB, fullImpulse));
+	Vector3 velocity	= object.GetLinearVelocity();
+	float	into		= Vector3::Dot(velocity, normal);
+	if (into > 0.0f)
+		object.linearVelocity = velocity - (normal * into);
 }
 
+/*
+Physics thread. The game only empties the event queue once a frame, and might be waiting
+on this thread to stop, so anything that doesn't fit is held on to until there's room -
+a dropped COLLECTED or COLLISION_END would never be made up for.
+*/
+void PhysicsSystem::QueueEvent(const PhysicsEvent& e) {
+	if (eventOverflow.empty() && eventQueue.Push(e))
+		return;
+	if (eventOverflow.empty())
+		std::cout << "Physics event queue is full, holding events until the game catches up" << std::endl;
+	eventOverflow.emplace_back(e);
+}
+
+void PhysicsSystem::FlushEventOverflow() {
+	size_t sent = 0;
+	while (sent < eventOverflow.size() && eventQueue.Push(eventOverflow[sent]))
+		++sent;
+	eventOverflow.erase(eventOverflow.begin(), eventOverflow.begin() + sent);
+}
+
+// the game removes collected objects from the world once it's been told about them
 void PhysicsSystem::CollectableCollision(GameObject& collectableObject) {
-	collectableObject.GetPhysicsObject()->SetUseGravity(false);
-	// if collected, move object outside of game world... prevents issues with deleting and resetting objects
-	// if number of collectable objects were many, this wouldn't be a good solution... but in this game there's only 11
-	collectableObject.GetTransform().SetWorldPosition(Vector3(0, -50, -40));
-	collectableObject.SetCollected(true);
+	ReportCollected(collectableObject);
+}
+
+void PhysicsSystem::ReportCollidedWith(GameObject& object, CollisionType collisionType) {
+	if (!threaded) {
+		object.SetCollidedWith(collisionType);
+		return;
+	}
+	QueueEvent({ PhysicsEventType::COLLIDED_WITH, &object, nullptr, collisionType });
+}
+
+void PhysicsSystem::ReportCollected(GameObject& object) {
+	if (!threaded) {
+		SetCollected(object);
+		return;
+	}
+	QueueEvent({ PhysicsEventType::COLLECTED, &object, nullptr, CollisionType::NONE });
+}
+
+void PhysicsSystem::ReportCollisionBegin(GameObject& object, GameObject& otherObject) {
+	if (!threaded) {
+		object.OnCollisionBegin(&otherObject);
+		return;
+	}
+	QueueEvent({ PhysicsEventType::COLLISION_BEGIN, &object, &otherObject, CollisionType::NONE });
+}
+
+void PhysicsSystem::ReportCollisionEnd(GameObject& object, GameObject& otherObject) {
+	if (!threaded) {
+		object.OnCollisionEnd(&otherObject);
+		return;
+	}
+	QueueEvent({ PhysicsEventType::COLLISION_END, &object, &otherObject, CollisionType::NONE });
+}
+
+// the collectable keeps being touched until the game gets rid of it, but only the first time counts
+void PhysicsSystem::SetCollected(GameObject& object) {
+	if (object.IsCollected()) {
+		return;
+	}
+	object.SetCollected(true);
+	if (collectedCallback) {
+		collectedCallback(&object);
+	}
 }
 
 /*
@@ -261,31 +625,46 @@ and a narrowphase collision detection method. In the broad phase, we
 split the world up using an acceleration structure, so that we can only
 compare the collisions that we absolutely need to. 
 
+Only moving bodies go in the per-frame tree. Each of them then checks the static
+tree for anything it overlaps, so pairs of static objects are never generated.
+
 */
 
 void PhysicsSystem::BroadPhase() {
-	QuadTree<GameObject*> tree(Vector2(1024, 1024), 7, 6);
-
-	std::vector<GameObject*>::const_iterator first;
-	std::vector<GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
+	if (broadphaseStructure == BroadphaseStructure::OCTREE) {
+		OctreeBroadPhase();
+		return;
+	}
+	dynamicTree.Reset();
 
-	for (auto i = first; i != last; ++i) {
+	auto insertMoving = [&](GameObject* object) {
+		Vector3 pos;
 		Vector3 halfSizes;
-		if (!(*i)->GetBroadphaseAABB(halfSizes))
-			continue;
-		Vector3 pos = (*i)->GetConstTransform().GetWorldPosition();
-		tree.Insert(*i, pos, halfSizes);
+		if (!GetMovingAABB(*object, pos, halfSizes))
+			return;
+		dynamicTree.Insert(object, pos, halfSizes);
+
+		if (staticTree) {
+			staticTree->OperateOnOverlapping(pos, halfSizes, [&](QuadTreeEntry<GameObject*>& entry) {
+				AddBroadphasePair(object, entry.object);
+			});
+		}
+	};
+	for (GameObject* i : kinematicBodies) {
+		insertMoving(i);
+	}
+	for (GameObject* i : dynamicBodies) {
+		insertMoving(i);
 	}
 
 	// [&] = capture variables by reference
-	tree.OperateOnContents([&](std::list<QuadTreeEntry<GameObject*>>& data) {
-		CollisionDetection::CollisionInfo info;
+	dynamicTree.OperateOnContents([&](QuadTreeSpan<GameObject*> data) {
 		for (auto i = data.begin(); i != data.end(); ++i) {
-			for (auto j = std::next(i); j != data.end(); ++j) {
-				info.a = min((*i).object, (*j).object);
-				info.b = max((*i).object, (*j).object);
-				broadphaseCollisions.insert(info);
+			for (auto j = i + 1; j != data.end(); ++j) {
+				// kinematic pairs can't respond to each other either
+				if (!i->object->GetPhysicsObject()->IsDynamic() && !j->object->GetPhysicsObject()->IsDynamic())
+					continue;
+				AddBroadphasePair(i->object, j->object);
 			}
 		}
 	});
@@ -293,73 +672,227 @@ void PhysicsSystem::BroadPhase() {
 
 /*
 
+The octree version of the above. Objects only ever sit in one octree node, so
+instead of testing everything in each leaf, we ask the tree for every pair of
+overlapping AABBs - which also means pairs don't get found multiple times.
+
+*/
+void PhysicsSystem::OctreeBroadPhase() {
+	Octree<GameObject*> tree(1024.0f, 7, 6);
+
+	auto insertMoving = [&](GameObject* object) {
+		Vector3 pos;
+		Vector3 halfSizes;
+		if (!GetMovingAABB(*object, pos, halfSizes))
+			return;
+		tree.Insert(object, pos, halfSizes);
+
+		if (staticOctree) {
+			staticOctree->OperateOnOverlapping(pos, halfSizes, [&](OctreeEntry<GameObject*>& entry) {
+				AddBroadphasePair(object, entry.object);
+			});
+		}
+	};
+	for (GameObject* i : kinematicBodies) {
+		insertMoving(i);
+	}
+	for (GameObject* i : dynamicBodies) {
+		insertMoving(i);
+	}
+
+	tree.OperateOnPairs([&](OctreeEntry<GameObject*>& a, OctreeEntry<GameObject*>& b) {
+		if (!a.object->GetPhysicsObject()->IsDynamic() && !b.object->GetPhysicsObject()->IsDynamic())
+			return;
+		AddBroadphasePair(a.object, b.object);
+	});
+}
+
+bool PhysicsSystem::GetMovingAABB(const GameObject& object, Vector3& pos, Vector3& halfSizes) const {
+	if (threaded) {
+		if (!object.GetBoundingVolume())
+			return false;
+		halfSizes = physicsAABBs[threadBodyIndices.at(&object)];
+	}
+	else if (!object.GetBroadphaseAABB(halfSizes))
+		return false;
+	pos = object.GetConstPhysicsTransform().GetWorldPosition();
+
+	// cover everywhere the object could get to this step
+	if (useSpeculativeContacts) {
+		Vector3 sweep = object.GetPhysicsObject()->GetLinearVelocity() * stepDt;
+		pos += sweep * 0.5f;
+		halfSizes += Vector3(abs(sweep.x), abs(sweep.y), abs(sweep.z)) * 0.5f;
+	}
+	return true;
+}
+
+void PhysicsSystem::AddBroadphasePair(GameObject* a, GameObject* b) {
+	CollisionDetection::CollisionInfo info;
+	info.a = min(a, b);
+	info.b = max(a, b);
+	broadphaseCollisions.insert(info);
+}
+
+/*
+
 The broadphase will now only give us likely collisions, so we can now go through them,
 and work out if they are truly colliding, and if so, add them into the main collision list
+
+Sphere / sphere and AABB / sphere pairs (most of what moves in our levels) are sorted into
+buckets and tested all at once, see BatchCollision.h - everything else goes through
+ObjectIntersection one pair at a time. The batches are tested up front, before anything
+has been resolved, so a batched pair whose bodies have since been pushed apart by an
+earlier pair is tested again where they are now - pairs are still resolved one after
+another, each seeing where the ones before it left things.
 */
 void PhysicsSystem::NarrowPhase() {
+	sphereSphereBatch.Clear();
+	aabbSphereBatch.Clear();
+	narrowPhasePairs.clear();
+
 	for (std::set<CollisionDetection::CollisionInfo>::iterator i = broadphaseCollisions.begin(); i != broadphaseCollisions.end(); ++i) {
-		CollisionDetection::CollisionInfo info = *i;
-		if (CollisionDetection::ObjectIntersection(info.a, info.b, info)) {
-			info.framesLeft = numCollisionFrames;
-			
-			ImpulseResolveCollision(*info.a, *info.b, info.point);
-			// @TODO find a better way of doing this then nested switches... bit of a mess
-			switch (info.a->GetPhysicsObject()->GetCollisionType()) {
-			case CollisionType::PLAYER:
-				switch (info.b->GetPhysicsObject()->GetCollisionType()) {
-				case CollisionType::LAKE:
-					info.a->SetCollidedWith(CollisionType::LAKE); break;
-				case CollisionType::COLLECTABLE:
-					CollectableCollision(*info.b); break;
-				case CollisionType::TRAMPOLINE:
-					info.a->SetCollidedWith(CollisionType::TRAMPOLINE); break;
-				case CollisionType::HOME:
-					info.a->SetCollidedWith(CollisionType::HOME); break;
-				case CollisionType::FLOOR:
-					info.a->SetCollidedWith(CollisionType::FLOOR); break;
-				case CollisionType::AI:
-					info.a->SetCollidedWith(CollisionType::AI); break;
+		NarrowPhasePair pair;
+		pair.info		= *i;
+		pair.bucket		= NarrowPhaseBucket::GENERIC;
+		pair.index		= 0;
+		pair.swapped	= false;
+
+		const CollisionVolume* volA = i->a->GetBoundingVolume();
+		const CollisionVolume* volB = i->b->GetBoundingVolume();
+		if (volA && volB) {
+			Vector3 posA = i->a->GetConstPhysicsTransform().GetWorldPosition();
+			Vector3 posB = i->b->GetConstPhysicsTransform().GetWorldPosition();
+
+			if (volA->type == VolumeType::Sphere && volB->type == VolumeType::Sphere) {
+				pair.bucket	= NarrowPhaseBucket::SPHERE_SPHERE;
+				pair.index	= sphereSphereBatch.Size();
+				sphereSphereBatch.Add(posA, ((const SphereVolume*)volA)->GetRadius(), posB, ((const SphereVolume*)volB)->GetRadius());
+			}
+			else if (volA->type == VolumeType::AABB && volB->type == VolumeType::Sphere) {
+				pair.bucket	= NarrowPhaseBucket::AABB_SPHERE;
+				pair.index	= aabbSphereBatch.Size();
+				aabbSphereBatch.Add(posA, ((const AABBVolume*)volA)->GetHalfDimensions(), posB, ((const SphereVolume*)volB)->GetRadius());
+			}
+			else if (volA->type == VolumeType::Sphere && volB->type == VolumeType::AABB) {
+				// the AABB has to be object a, as with AABBSphereIntersection
+				pair.bucket		= NarrowPhaseBucket::AABB_SPHERE;
+				pair.index		= aabbSphereBatch.Size();
+				pair.swapped	= true;
+				aabbSphereBatch.Add(posB, ((const AABBVolume*)volB)->GetHalfDimensions(), posA, ((const SphereVolume*)volA)->GetRadius());
+			}
+		}
+		narrowPhasePairs.emplace_back(pair);
+	}
+
+	sphereSphereBatch.Run();
+	aabbSphereBatch.Run();
+
+	narrowPhaseMoved.clear();
+	for (const NarrowPhasePair& pair : narrowPhasePairs) {
+		CollisionDetection::CollisionInfo info = pair.info;
+		bool colliding = false;
+
+		NarrowPhaseBucket bucket = pair.bucket;
+		if (bucket != NarrowPhaseBucket::GENERIC && (narrowPhaseMoved.count(info.a) || narrowPhaseMoved.count(info.b)))
+			bucket = NarrowPhaseBucket::GENERIC;	// the batch result is out of date
+
+		switch (bucket) {
+		case NarrowPhaseBucket::SPHERE_SPHERE:
+			if (sphereSphereBatch.hit[pair.index]) {
+				Vector3 normal = sphereSphereBatch.GetNormal(pair.index);
+				info.AddContactPoint(normal * sphereSphereBatch.radiusA[pair.index], -normal * sphereSphereBatch.radiusB[pair.index],
+					normal, sphereSphereBatch.penetration[pair.index]);
+				colliding = true;
+			}
+			break;
+		case NarrowPhaseBucket::AABB_SPHERE:
+			if (aabbSphereBatch.hit[pair.index]) {
+				if (pair.swapped) {
+					std::swap(info.a, info.b);
 				}
-				break;
-			case CollisionType::LAKE:
-				if (info.b->GetPhysicsObject()->GetCollisionType() == CollisionType::PLAYER)
-					info.b->SetCollidedWith(CollisionType::LAKE); 
-				break;
-			case CollisionType::COLLECTABLE:
-				if (info.b->GetPhysicsObject()->GetCollisionType() == CollisionType::PLAYER)
-					CollectableCollision(*info.a);
-				break;
-			case CollisionType::TRAMPOLINE:
-				if (info.b->GetPhysicsObject()->GetCollisionType() == CollisionType::PLAYER)
-					info.b->SetCollidedWith(CollisionType::TRAMPOLINE); 
-				break;
-			case CollisionType::HOME:
-				if (info.b->GetPhysicsObject()->GetCollisionType() == CollisionType::PLAYER)
-					info.b->SetCollidedWith(CollisionType::HOME); 
-				break;
-			case CollisionType::FLOOR:
-				if (info.b->GetPhysicsObject()->GetCollisionType() == CollisionType::PLAYER)
-					info.b->SetCollidedWith(CollisionType::FLOOR); 
-				break;
-			case CollisionType::IMMOVABLE:
-				if (info.b->GetPhysicsObject()->GetCollisionType() == CollisionType::WALL)
-					info.a->SetCollidedWith(CollisionType::WALL); 
-				break;
-			case CollisionType::WALL:
-				if (info.b->GetPhysicsObject()->GetCollisionType() == CollisionType::IMMOVABLE)
-					info.b->SetCollidedWith(CollisionType::WALL);
-				break;
-			case CollisionType::AI:
-				if (info.b->GetPhysicsObject()->GetCollisionType() == CollisionType::PLAYER)
-					info.b->SetCollidedWith(CollisionType::AI);
-				break;
-			default:
-				info.a->SetCollidedWith(CollisionType::DEFAULT); info.b->SetCollidedWith(CollisionType::DEFAULT);
+				Vector3 normal = aabbSphereBatch.GetNormal(pair.index);
+				info.AddContactPoint(Vector3(), -normal * aabbSphereBatch.radius[pair.index], normal, aabbSphereBatch.penetration[pair.index]);
+				colliding = true;
 			}
-			// insert into main set
-			allCollisions.insert(info);
+			break;
+		default:
+			colliding = CollisionDetection::ObjectIntersection(info.a, info.b, info);
+		}
+
+		if (colliding) {
+			ResolveNarrowPhaseCollision(info);
+			// only dynamic bodies get projected out
+			if (info.a->GetPhysicsObject()->IsDynamic())
+				narrowPhaseMoved.insert(info.a);
+			if (info.b->GetPhysicsObject()->IsDynamic())
+				narrowPhaseMoved.insert(info.b);
+		}
+		else if (useSpeculativeContacts) {
+			info = pair.info;
+			SpeculativeContact(info);
+		}
+	}
+}
+
+void PhysicsSystem::ResolveNarrowPhaseCollision(CollisionDetection::CollisionInfo& info) {
+	info.framesLeft = numCollisionFrames;
+
+	ImpulseResolveCollision(*info.a, *info.b, info.point);
+	// @TODO find a better way of doing this then nested switches... bit of a mess
+	switch (info.a->GetPhysicsObject()->GetCollisionType()) {
+	case CollisionType::PLAYER:
+		switch (info.b->GetPhysicsObject()->GetCollisionType()) {
+		case CollisionType::LAKE:
+			ReportCollidedWith(*info.a, CollisionType::LAKE); break;
+		case CollisionType::COLLECTABLE:
+			CollectableCollision(*info.b); break;
+		case CollisionType::TRAMPOLINE:
+			ReportCollidedWith(*info.a, CollisionType::TRAMPOLINE); break;
+		case CollisionType::HOME:
+			ReportCollidedWith(*info.a, CollisionType::HOME); break;
+		case CollisionType::FLOOR:
+			ReportCollidedWith(*info.a, CollisionType::FLOOR); break;
+		case CollisionType::AI:
+			ReportCollidedWith(*info.a, CollisionType::AI); break;
 		}
+		break;
+	case CollisionType::LAKE:
+		if (info.b->GetPhysicsObject()->GetCollisionType() == CollisionType::PLAYER)
+			ReportCollidedWith(*info.b, CollisionType::LAKE); 
+		break;
+	case CollisionType::COLLECTABLE:
+		if (info.b->GetPhysicsObject()->GetCollisionType() == CollisionType::PLAYER)
+			CollectableCollision(*info.a);
+		break;
+	case CollisionType::TRAMPOLINE:
+		if (info.b->GetPhysicsObject()->GetCollisionType() == CollisionType::PLAYER)
+			ReportCollidedWith(*info.b, CollisionType::TRAMPOLINE); 
+		break;
+	case CollisionType::HOME:
+		if (info.b->GetPhysicsObject()->GetCollisionType() == CollisionType::PLAYER)
+			ReportCollidedWith(*info.b, CollisionType::HOME); 
+		break;
+	case CollisionType::FLOOR:
+		if (info.b->GetPhysicsObject()->GetCollisionType() == CollisionType::PLAYER)
+			ReportCollidedWith(*info.b, CollisionType::FLOOR); 
+		break;
+	case CollisionType::IMMOVABLE:
+		if (info.b->GetPhysicsObject()->GetCollisionType() == CollisionType::WALL)
+			ReportCollidedWith(*info.a, CollisionType::WALL); 
+		break;
+	case CollisionType::WALL:
+		if (info.b->GetPhysicsObject()->GetCollisionType() == CollisionType::IMMOVABLE)
+			ReportCollidedWith(*info.b, CollisionType::WALL);
+		break;
+	case CollisionType::AI:
+		if (info.b->GetPhysicsObject()->GetCollisionType() == CollisionType::PLAYER)
+			ReportCollidedWith(*info.b, CollisionType::AI);
+		break;
+	default:
+		ReportCollidedWith(*info.a, CollisionType::DEFAULT); ReportCollidedWith(*info.b, CollisionType::DEFAULT);
 	}
+	// insert into main set
+	allCollisions.insert(info);
 }
 
 /*
@@ -372,14 +905,7 @@ based on any forces that have been accumulated in the objects during
 the course of the previous game frame.
 */
 void PhysicsSystem::IntegrateAccel(float dt) {
-	std::vector<GameObject*>::const_iterator first;
-	std::vector<GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
-
-	for (auto i = first; i != last; ++i) {
-		PhysicsObject* object = (*i)->GetPhysicsObject();
-		if (object == nullptr)
-			continue;	// GameObject doesn't have physics object
+	for (PhysicsObject* object : dynamicObjects) {
 		
 		float inverseMass = object->GetInverseMass();
 
@@ -388,11 +914,11 @@ void PhysicsSystem::IntegrateAccel(float dt) {
 		Vector3 accel = force * inverseMass;
 
 		// don't do this for objects that can't be moved
-		if (applyGravity && inverseMass > 0 && (*i)->GetPhysicsObject()->UseGravity())
+		if (applyGravity && inverseMass > 0 && object->UseGravity())
 			accel += gravity;
 
 		linearVel += accel * dt;	// integrate acceleration
-		object->SetLinearVelocity(linearVel);
+		object->linearVelocity = linearVel;
 
 		
 		// angular calculations
@@ -405,7 +931,7 @@ void PhysicsSystem::IntegrateAccel(float dt) {
 
 		// integrate angular acceleration
 		angVel += angAccel * dt;
-		object->SetAngularVelocity(angVel);
+		object->angularVelocity = angVel;
 	}
 }
 
@@ -416,46 +942,47 @@ throughout a physics update, to slowly move the objects through
 the world, looking for collisions.
 */
 void PhysicsSystem::IntegrateVelocity(float dt) {
-	std::vector<GameObject*>::const_iterator first;
-	std::vector<GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
 	float dampingFactor = 1.0f - 0.95f;
 	float frameDamping = powf(dampingFactor, dt);
 	
-	for (auto i = first; i != last; ++i) {
-		PhysicsObject* object = (*i)->GetPhysicsObject();
-		if (object == nullptr)
-			continue;
+	for (PhysicsObject* i : dynamicObjects) {
+		IntegrateBodyVelocity(i, dt, frameDamping);
+	}
+	// kinematic velocities come from their targets, so aren't damped
+	for (PhysicsObject* i : kinematicObjects) {
+		IntegrateBodyVelocity(i, dt, 1.0f);
+	}
+}
 
-		Transform& transform = (*i)->GetTransform();
+void PhysicsSystem::IntegrateBodyVelocity(PhysicsObject* object, float dt, float damping) {
+	Transform& transform = *object->GetTransform();
 
-		// position stuff
-		Vector3 position = transform.GetLocalPosition();
-		Vector3 linearVel = object->GetLinearVelocity();
-		position += linearVel * dt;		// integrate velocity
-		transform.SetLocalPosition(position);
-		// added later
-		transform.SetWorldPosition(position);
+	// position stuff
+	Vector3 position = transform.GetLocalPosition();
+	Vector3 linearVel = object->GetLinearVelocity();
+	position += linearVel * dt;		// integrate velocity
+	transform.SetLocalPosition(position);
+	// added later
+	transform.SetWorldPosition(position);
 
-		// linear damping - simulate drag/air resistance by reducing linearVelocity each frame
-		linearVel = linearVel * frameDamping;
-		object->SetLinearVelocity(linearVel);
+	// linear damping - simulate drag/air resistance by reducing linearVelocity each frame
+	linearVel = linearVel * damping;
+	object->linearVelocity = linearVel;
 
 
-		// orientation calculations
-		Quaternion orientation = transform.GetLocalOrientation();
-		Vector3 angVel = object->GetAngularVelocity();
+	// orientation calculations
+	Quaternion orientation = transform.GetLocalOrientation();
+	Vector3 angVel = object->GetAngularVelocity();
 
-		// integrate angular velocity. * 0.5 is just a quaternion quirk
-		orientation = orientation + (Quaternion(angVel * dt * 0.5f, 0.0f) * orientation);
-		orientation.Normalise();
+	// integrate angular velocity. * 0.5 is just a quaternion quirk
+	orientation = orientation + (Quaternion(angVel * dt * 0.5f, 0.0f) * orientation);
+	orientation.Normalise();
 
-		transform.SetLocalOrientation(orientation);
+	transform.SetLocalOrientation(orientation);
 
-		// damping for angular velocity to prevent forever spinning
-		angVel = angVel * frameDamping;
-		object->SetAngularVelocity(angVel);
-	}
+	// damping for angular velocity to prevent forever spinning
+	angVel = angVel * damping;
+	object->angularVelocity = angVel;
 }
 
 /*
@@ -464,13 +991,12 @@ clear out any accumulated forces, ready to receive new
 ones in the next 'game' frame.
 */
 void PhysicsSystem::ClearForces() {
-	std::vector<GameObject*>::const_iterator first;
-	std::vector<GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
-
-	for (auto i = first; i != last; ++i) {
-		//Clear our object's forces for the next frame
-		(*i)->GetPhysicsObject()->ClearForces();
+	//Clear our object's forces for the next frame
+	for (PhysicsObject* i : kinematicObjects) {
+		i->ClearForces();
+	}
+	for (PhysicsObject* i : dynamicObjects) {
+		i->ClearForces();
 	}
 }
 
@@ -490,4 +1016,238 @@ void PhysicsSystem::UpdateConstraints(float dt) {
 	for (auto i = first; i != last; ++i) {
 		(*i)->UpdateConstraint(dt);
 	}
-}
\ No newline at end of file
+}
+
+/*
+
+Threaded physics - the physics thread just runs UpdateStep at a fixed rate, and
+works on its own copy of each object's transform, so the game can carry on reading
+and writing the real ones. Anything the game changes gets sent over in the command
+queue, and after every step the new positions and velocities are written into a
+snapshot for the main thread to pick up in Update.
+
+*/
+void PhysicsSystem::StartThread(float updateRate) {
+	if (threaded)
+		return;
+
+	UpdateBodyLists();
+
+	threadBodies.clear();
+	threadBodies.insert(threadBodies.end(), staticBodies.begin(), staticBodies.end());
+	threadBodies.insert(threadBodies.end(), kinematicBodies.begin(), kinematicBodies.end());
+	threadBodies.insert(threadBodies.end(), dynamicBodies.begin(), dynamicBodies.end());
+
+	// filled before any pointers are taken, as the vector mustn't reallocate
+	physicsTransforms.clear();
+	physicsTransforms.reserve(threadBodies.size());
+	for (GameObject* i : threadBodies) {
+		physicsTransforms.emplace_back(i->GetTransform());
+	}
+
+	commandQueue.Clear();
+	eventQueue.Clear();
+	threadBodyIndices.clear();
+	syncedStates.clear();
+	appliedVersions.clear();
+	physicsAABBs.assign(threadBodies.size(), Vector3());
+
+	for (int i = 0; i < (int)threadBodies.size(); ++i) {
+		PhysicsObject* object = threadBodies[i]->GetPhysicsObject();
+		object->SetTransform(&physicsTransforms[i]);
+		object->SetCommandQueue(&commandQueue);
+		threadBodyIndices[threadBodies[i]] = i;
+		threadBodies[i]->GetAABB(physicsTransforms[i], physicsAABBs[i]);
+
+		BodyState state;
+		state.position			= physicsTransforms[i].GetWorldPosition();
+		state.orientation		= physicsTransforms[i].GetLocalOrientation();
+		state.linearVelocity	= object->GetLinearVelocity();
+		state.angularVelocity	= object->GetAngularVelocity();
+		syncedStates.emplace_back(state);
+
+		const Transform& gameTransform = threadBodies[i]->GetTransform();
+		appliedVersions.push_back({ gameTransform.GetPositionVersion(), gameTransform.GetOrientationVersion() });
+	}
+	snapshots[0]	= syncedStates;
+	snapshots[1]	= syncedStates;
+	frontSnapshot	= 0;
+	newSnapshot		= false;
+	dTOffset		= 0.0f;
+
+	threaded		= true;
+	threadRate		= updateRate;
+	threadRunning	= true;
+	physicsThread	= std::thread(&PhysicsSystem::ThreadLoop, this, 1.0f / updateRate);
+}
+
+void PhysicsSystem::StopThread() {
+	if (!threaded)
+		return;
+
+	threadRunning = false;
+	physicsThread.join();
+
+	// physics is back on this thread, so anything still queued can be applied directly
+	ApplyCommands();
+	DispatchEvents();
+	while (!eventOverflow.empty()) {
+		FlushEventOverflow();
+		DispatchEvents();
+	}
+
+	for (int i = 0; i < (int)threadBodies.size(); ++i) {
+		GameObject* body = threadBodies[i];
+		Transform& gameTransform = body->GetTransform();
+
+		// copy the simulated state back, unless the game has moved the object itself since the last sync
+		if (gameTransform.GetPositionVersion() == appliedVersions[i].position)
+			gameTransform.SetWorldPosition(physicsTransforms[i].GetWorldPosition());
+		if (gameTransform.GetOrientationVersion() == appliedVersions[i].orientation)
+			gameTransform.SetLocalOrientation(physicsTransforms[i].GetLocalOrientation());
+
+		body->GetPhysicsObject()->SetTransform(&gameTransform);
+		body->GetPhysicsObject()->SetCommandQueue(nullptr);
+	}
+	threaded = false;
+
+	threadBodies.clear();
+	physicsTransforms.clear();
+	physicsAABBs.clear();
+	threadBodyIndices.clear();
+}
+
+void PhysicsSystem::ThreadLoop(float timestep) {
+	auto stepDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(timestep));
+	auto nextStep = std::chrono::steady_clock::now();
+
+	while (threadRunning) {
+		ApplyCommands();
+		UpdateStep(timestep);
+		WriteSnapshot();
+
+		nextStep += stepDuration;
+		auto now = std::chrono::steady_clock::now();
+		// if we've fallen a long way behind, don't try to catch up
+		if (now > nextStep + stepDuration * 8) {
+			nextStep = now;
+		}
+		std::this_thread::sleep_until(nextStep);
+	}
+}
+
+// physics thread
+void PhysicsSystem::ApplyCommands() {
+	PhysicsCommand command;
+	while (commandQueue.Pop(command)) {
+		command.object->ApplyCommand(command);
+	}
+}
+
+// physics thread
+void PhysicsSystem::WriteSnapshot() {
+	FlushEventOverflow();
+
+	std::vector<BodyState>& back = snapshots[1 - frontSnapshot];
+
+	for (int i = 0; i < (int)threadBodies.size(); ++i) {
+		PhysicsObject* object = threadBodies[i]->GetPhysicsObject();
+		back[i].position		= physicsTransforms[i].GetWorldPosition();
+		back[i].orientation		= physicsTransforms[i].GetLocalOrientation();
+		back[i].linearVelocity	= object->GetLinearVelocity();
+		back[i].angularVelocity = object->GetAngularVelocity();
+	}
+
+	std::lock_guard<std::mutex> lock(snapshotMutex);
+	frontSnapshot	= 1 - frontSnapshot;
+	newSnapshot		= true;
+}
+
+// main thread
+void PhysicsSystem::ReadSnapshot() {
+	{
+		std::lock_guard<std::mutex> lock(snapshotMutex);
+		if (!newSnapshot)
+			return;
+		syncedStates	= snapshots[frontSnapshot];
+		newSnapshot		= false;
+	}
+
+	for (int i = 0; i < (int)threadBodies.size(); ++i) {
+		Transform& transform = threadBodies[i]->GetTransform();
+		AppliedVersion& applied = appliedVersions[i];
+
+		// if the game has moved or turned the object since we last wrote to it, that wins
+		if (transform.GetPositionVersion() != applied.position)
+			QueueTransformCommand(PhysicsCommandType::SET_POSITION, *threadBodies[i]);
+		else
+			transform.SetWorldPosition(syncedStates[i].position);
+		applied.position = transform.GetPositionVersion();
+
+		if (transform.GetOrientationVersion() != applied.orientation)
+			QueueTransformCommand(PhysicsCommandType::SET_ORIENTATION, *threadBodies[i]);
+		else
+			transform.SetLocalOrientation(syncedStates[i].orientation);
+		applied.orientation = transform.GetOrientationVersion();
+	}
+}
+
+// main thread
+void PhysicsSystem::DispatchEvents() {
+	PhysicsEvent e;
+	while (eventQueue.Pop(e)) {
+		switch (e.type) {
+		case PhysicsEventType::COLLIDED_WITH:
+			e.object->SetCollidedWith(e.collisionType); break;
+		case PhysicsEventType::COLLECTED:
+			SetCollected(*e.object); break;
+		case PhysicsEventType::COLLISION_BEGIN:
+			e.object->OnCollisionBegin(e.otherObject); break;
+		case PhysicsEventType::COLLISION_END:
+			e.object->OnCollisionEnd(e.otherObject); break;
+		}
+	}
+}
+
+void PhysicsSystem::QueueTransformCommand(PhysicsCommandType type, GameObject& object) {
+	PhysicsCommand command;
+	command.type		= type;
+	command.object		= object.GetPhysicsObject();
+	command.position	= object.GetTransform().GetWorldPosition();
+	command.orientation = object.GetTransform().GetLocalOrientation();
+	command.value		= 0.0f;
+	if (!commandQueue.PushOrWait(command))
+		std::cout << "Physics command queue was full, had to wait for the physics thread" << std::endl;
+}
+
+Vector3 PhysicsSystem::GetLinearVelocity(const GameObject& object) const {
+	if (threaded) {
+		auto i = threadBodyIndices.find(&object);
+		if (i != threadBodyIndices.end())
+			return syncedStates[i->second].linearVelocity;
+	}
+	return object.GetPhysicsObject() ? object.GetPhysicsObject()->GetLinearVelocity() : Vector3();
+}
+
+Vector3 PhysicsSystem::GetAngularVelocity(const GameObject& object) const {
+	if (threaded) {
+		auto i = threadBodyIndices.find(&object);
+		if (i != threadBodyIndices.end())
+			return syncedStates[i->second].angularVelocity;
+	}
+	return object.GetPhysicsObject() ? object.GetPhysicsObject()->GetAngularVelocity() : Vector3();
+}
+
+/*
+Objects that are about to touch get a contact that only stops them from overlapping,
+so there's no bounce and no gameplay events until they really do collide. The margin is
+how far the two objects can move relative to each other this step.
+*/
+void PhysicsSystem::SpeculativeContact(CollisionDetection::CollisionInfo& info) {
+	Vector3 relativeVelocity = info.b->GetPhysicsObject()->GetLinearVelocity() - info.a->GetPhysicsObject()->GetLinearVelocity();
+	float margin = relativeVelocity.Length() * stepDt;
+
+	if (CollisionDetection::SpeculativeIntersection(info.a, info.b, margin, info)) {
+		ImpulseResolveCollision(*info.a, *info.b, info.point);
+	}
+}
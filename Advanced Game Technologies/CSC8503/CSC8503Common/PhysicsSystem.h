@@ -1,6 +1,15 @@
 #pragma once
 #include "../CSC8503Common/GameWorld.h"
+#include "PhysicsObject.h"
+#include "LockFreeQueue.h"
+#include "FlatQuadTree.h"
+#include "BatchCollision.h"
 #include <set>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace NCL {
 	namespace CSC8503 {
@@ -21,33 +30,106 @@ namespace NCL {
 				useBroadPhase = state;
 			}
 
+			/*
+			Speculative contacts stretch each moving object's broadphase AABB by how far it will
+			move this step, and add contacts between objects that aren't touching yet but are
+			about to. Those contacts only remove the part of the closing velocity that would make
+			the objects overlap, which stops fast objects tunnelling through thin walls without
+			needing lots of small substeps.
+			*/
+			void UseSpeculativeContacts(bool state) {
+				useSpeculativeContacts = state;
+			}
+
+			bool UsingSpeculativeContacts() const {
+				return useSpeculativeContacts;
+			}
+
 			void SetGlobalDamping(float d) {
 				globalDamping = d;
 			}
 
 			void SetGravity(const Vector3& g);
+
+			/*
+			Runs the physics update on its own thread at a fixed rate. Game code can carry on using
+			PhysicsObject as normal - forces and other changes get queued up for the physics thread,
+			and Update just copies the latest results back into the game's transforms. Objects must
+			not be deleted while physics is threaded, so call StopThread before clearing the world!
+			*/
+			void StartThread(float updateRate = 120.0f);
+			void StopThread();
+
+			bool IsThreaded() const {
+				return threaded;
+			}
+
+			/*
+			Called on the main thread the first time each collectable is touched, so the game can
+			deal with pickups as they happen rather than checking every collectable each frame.
+			*/
+			void SetCollectedCallback(GameObjectFunc f) {
+				collectedCallback = f;
+			}
+
+			// safe to call from game code whether or not physics is threaded
+			Vector3 GetLinearVelocity(const GameObject& object) const;
+			Vector3 GetAngularVelocity(const GameObject& object) const;
 			
 		protected:
+			void UpdateStep(float dt);
+
 			void BasicCollisionDetection();
 			void BroadPhase();
+			void OctreeBroadPhase();
+			bool GetMovingAABB(const GameObject& object, Vector3& pos, Vector3& halfSizes) const;
+			void AddBroadphasePair(GameObject* a, GameObject* b);
 			void NarrowPhase();
+			void ResolveNarrowPhaseCollision(CollisionDetection::CollisionInfo& info);
 
 			void ClearForces();
 
+			void UpdateBodyLists();
+			void AddBody(GameObject* body);
+			void RemoveBody(GameObject* body);
+			void OnObjectAdded(GameObject* object);
+			void OnObjectRemoved(GameObject* object);
+			void UpdateKinematicBodies(float dt);
+
 			void IntegrateAccel(float dt);
 			void IntegrateVelocity(float dt);
+			void IntegrateBodyVelocity(PhysicsObject* object, float dt, float damping);
 
 			void UpdateConstraints(float dt);
 
 			void UpdateCollisionList();
 			void UpdateObjectAABBs();
 
+			void SpeculativeContact(CollisionDetection::CollisionInfo& info);
+
 			void ImpulseResolveCollision(GameObject& a , GameObject&b, CollisionDetection::ContactPoint& p) const;
+			static void PushKinematicOut(PhysicsObject& object, Transform& transform, const Vector3& normal, float penetration);
 			void CollectableCollision(GameObject& collectableObject);
+
+			// gameplay side effects of collisions, which get passed back to the main thread when threaded
+			void ReportCollidedWith(GameObject& object, CollisionType collisionType);
+			void ReportCollected(GameObject& object);
+			void ReportCollisionBegin(GameObject& object, GameObject& otherObject);
+			void ReportCollisionEnd(GameObject& object, GameObject& otherObject);
+			void SetCollected(GameObject& object);
+
+			void ThreadLoop(float timestep);
+			void ApplyCommands();
+			void WriteSnapshot();
+			void ReadSnapshot();
+			void DispatchEvents();
+			void QueueTransformCommand(PhysicsCommandType type, GameObject& object);
 			
 			GameWorld& gameWorld;
 
-			bool	applyGravity;
+			GameObjectFunc collectedCallback;
+
+			std::atomic<bool> applyGravity;
 			Vector3 gravity;
 			float	dTOffset;
 			float	globalDamping;
@@ -56,8 +138,112 @@ namespace NCL {
 			std::set<CollisionDetection::CollisionInfo> allCollisions;
 			std::set<CollisionDetection::CollisionInfo>		broadphaseCollisions;
 			std::vector<CollisionDetection::CollisionInfo>	broadphaseCollisionsVec;
-			bool useBroadPhase		= true;
+			std::atomic<bool> useBroadPhase	{ true };
+			std::atomic<bool> useSpeculativeContacts { false };
+			float	stepDt			= 0.0f;	// length of the step currently being simulated
 			int numCollisionFrames	= 5;
+
+			// body lists are rebuilt whenever the world's object list changes
+			std::vector<GameObject*> staticBodies;
+			std::vector<GameObject*> kinematicBodies;
+			std::vector<GameObject*> dynamicBodies;
+			// the same bodies' physics objects, in the same order - integration only needs these,
+			// so it doesn't have to go through each GameObject to get to them
+			std::vector<PhysicsObject*> kinematicObjects;
+			std::vector<PhysicsObject*> dynamicObjects;
+			std::vector<GameObject*> addedBodies;	// to be sorted in next update
+			int lastWorldState		= -1;
+			int removalCallback		= -1;
+			int additionCallback	= -1;
+
+			// statics never move, so they're put in their tree once, and taken out by handle
+			struct StaticEntry {
+				QuadTreeHandle	handle;
+				Vector3			pos;	// what the octree needs to find it again
+				Vector3			size;
+			};
+			QuadTree<GameObject*>*	staticTree		= nullptr;
+			Octree<GameObject*>*	staticOctree	= nullptr;
+			std::unordered_map<const GameObject*, StaticEntry> staticEntries;
+			BroadphaseStructure		broadphaseStructure = BroadphaseStructure::QUADTREE;
+
+			// moving objects are put in here every step, it's kept around so its memory can be reused
+			FlatQuadTree<GameObject*> dynamicTree { Vector2(1024, 1024), 7, 6 };
+
+			enum class NarrowPhaseBucket {
+				GENERIC,
+				SPHERE_SPHERE,
+				AABB_SPHERE
+			};
+
+			struct NarrowPhasePair {
+				CollisionDetection::CollisionInfo	info;
+				NarrowPhaseBucket					bucket;
+				size_t								index;		// into the bucket's batch
+				bool								swapped;	// object b is the AABB
+			};
+
+			// kept around between steps so their memory gets reused
+			std::vector<NarrowPhasePair>	narrowPhasePairs;
+			SphereSphereBatch				sphereSphereBatch;
+			AABBSphereBatch					aabbSphereBatch;
+			std::unordered_set<GameObject*>	narrowPhaseMoved;	// bodies already pushed apart this step
+
+			struct BodyState {
+				Vector3		position;
+				Quaternion	orientation;
+				Vector3		linearVelocity;
+				Vector3		angularVelocity;
+			};
+
+			enum class PhysicsEventType {
+				COLLIDED_WITH,
+				COLLECTED,
+				COLLISION_BEGIN,
+				COLLISION_END
+			};
+
+			struct PhysicsEvent {
+				PhysicsEventType	type;
+				GameObject*			object;
+				GameObject*			otherObject;
+				CollisionType		collisionType;
+			};
+
+			void QueueEvent(const PhysicsEvent& e);
+			void FlushEventOverflow();
+
+			// threaded physics
+			std::thread			physicsThread;
+			std::atomic<bool>	threadRunning	{ false };
+			bool				threaded		= false;
+			float				threadRate		= 120.0f;
+			bool				resumeThread	= false;	// stopped so an object could be removed
+
+			std::vector<GameObject*>	threadBodies;
+			std::vector<Transform>		physicsTransforms;	// what physics works on while threaded
+			std::vector<Vector3>		physicsAABBs;		// broadphase AABBs of the above, the game's objects are left alone
+			std::unordered_map<const GameObject*, int> threadBodyIndices;
+
+			// written by the physics thread after every step, the mutex only guards the swap
+			std::vector<BodyState>	snapshots[2];
+			int						frontSnapshot	= 0;
+			bool					newSnapshot		= false;
+			std::mutex				snapshotMutex;
+
+			// transform versions as of the last sync, anything newer is the game moving the object itself
+			struct AppliedVersion {
+				unsigned int position;
+				unsigned int orientation;
+			};
+
+			// main thread copy of the latest snapshot
+			std::vector<BodyState>		syncedStates;
+			std::vector<AppliedVersion>	appliedVersions;
+
+			PhysicsCommandQueue					commandQueue;	// game -> physics
+			LockFreeQueue<PhysicsEvent, 4096>	eventQueue;		// physics -> game
+			std::vector<PhysicsEvent>			eventOverflow;	// physics thread only, waiting for room in eventQueue
 		};
 	}
 }
@@ -1,8 +1,13 @@
 #pragma once
 #include "../../Common/Vector2.h"
+#include "../../Common/Frustum.h"
+#include "../../Common/Maths.h"
 #include "Debug.h"
+#include "Ray.h"
 #include <list>
+#include <vector>
 #include <functional>
+#include <cfloat>
 
 namespace NCL {
 	using namespace NCL::Maths;
@@ -15,11 +20,22 @@ namespace NCL {
 			Vector3 pos;
 			Vector3 size;
 			T object;
+			int handle;	// index of the QuadTreeHandle the entry was inserted with, if any
 
-			QuadTreeEntry(T obj, Vector3 pos, Vector3 size) {
+			QuadTreeEntry(T obj, Vector3 pos, Vector3 size, int handle = -1) {
 				object		= obj;
 				this->pos	= pos;
 				this->size	= size;
+				this->handle = handle;
+			}
+		};
+
+		// returned by QuadTree::Insert, so the object can be moved or removed without searching for it
+		struct QuadTreeHandle {
+			int index = -1;
+
+			bool IsValid() const {
+				return index >= 0;
 			}
 		};
 
@@ -27,6 +43,9 @@ namespace NCL {
 		class QuadTreeNode	{
 		public:
 			typedef std::function<void(std::list<QuadTreeEntry<T>>&)> QuadTreeFunc;
+			typedef std::function<void(QuadTreeEntry<T>&)> QuadTreeEntryFunc;
+			typedef std::function<bool(const Vector3&, const Vector3&)> QuadTreeBoundsFunc;
+			typedef std::function<void(QuadTreeEntry<T>&, float&)> QuadTreeRayEntryFunc;
 		protected:
 			friend class QuadTree<T>;
 
@@ -42,15 +61,24 @@ namespace NCL {
 				delete[] children;
 			}
 
-			void Insert(T& object, const Vector3& objectPos, const Vector3& objectSize, int depthLeft, int maxSize) {
-				if (!CollisionDetection::AABBTest(objectPos, Vector3(position.x, 0, position.y), objectSize, Vector3(size.x, 1000.0f, size.y)))
+			bool Overlaps(const Vector3& objectPos, const Vector3& objectSize) const {
+				return CollisionDetection::AABBTest(objectPos, Vector3(position.x, 0, position.y), objectSize, Vector3(size.x, 1000.0f, size.y));
+			}
+
+			bool Contains(const Vector3& objectPos, const Vector3& objectSize) const {
+				return	abs(objectPos.x - position.x) + objectSize.x <= size.x &&
+						abs(objectPos.z - position.y) + objectSize.z <= size.y;
+			}
+
+			void Insert(T& object, const Vector3& objectPos, const Vector3& objectSize, int depthLeft, int maxSize, int handle = -1) {
+				if (!Overlaps(objectPos, objectSize))
 					return;
 				// not a leaf node so descend down tree
 				if (children)
 					for (int i = 0; i < 4; ++i)
-						children[i].Insert(object, objectPos, objectSize, depthLeft - 1, maxSize);
+						children[i].Insert(object, objectPos, objectSize, depthLeft - 1, maxSize, handle);
 				else {	// leaf node so expand
-					contents.push_back(QuadTreeEntry<T>(object, objectPos, objectSize));
+					contents.push_back(QuadTreeEntry<T>(object, objectPos, objectSize, handle));
 					if ((int)contents.size() > maxSize && depthLeft > 0) {
 						if (!children) {
 							Split();
@@ -58,7 +86,7 @@ namespace NCL {
 							for (const auto& i : contents) {
 								for (int j = 0; j < 4; ++j) {
 									auto entry = i;
-									children[j].Insert(entry.object, entry.pos, entry.size, depthLeft - 1, maxSize);
+									children[j].Insert(entry.object, entry.pos, entry.size, depthLeft - 1, maxSize, entry.handle);
 								}
 							}
 							contents.clear();
@@ -67,6 +95,161 @@ namespace NCL {
 				}
 			}
 
+			// an object is in every leaf its AABB overlaps, so that's where we look for it
+			bool Remove(const T& object, const Vector3& objectPos, const Vector3& objectSize, int maxSize) {
+				if (!Overlaps(objectPos, objectSize))
+					return false;
+				if (children) {
+					bool removed = false;
+					for (int i = 0; i < 4; ++i)
+						removed |= children[i].Remove(object, objectPos, objectSize, maxSize);
+					if (removed)
+						Merge(maxSize);
+					return removed;
+				}
+				size_t oldSize = contents.size();
+				contents.remove_if([&](const QuadTreeEntry<T>& e) { return e.object == object; });
+				return contents.size() != oldSize;
+			}
+
+			/*
+			Moves an object from its old AABB to its new one. Only nodes overlapping either
+			AABB are visited, and leaves that the object was already in, and still is, just
+			have the entry changed in place. Returns true if the object left any leaves, as
+			that's the only time nodes might need merging.
+			*/
+			bool Update(T& object, const Vector3& oldPos, const Vector3& oldSize, const Vector3& newPos, const Vector3& newSize, int depthLeft, int maxSize, int handle) {
+				bool inOld = Overlaps(oldPos, oldSize);
+				bool inNew = Overlaps(newPos, newSize);
+				if (!inOld && !inNew)
+					return false;
+				if (!inOld) {
+					Insert(object, newPos, newSize, depthLeft, maxSize, handle);
+					return false;
+				}
+				if (!inNew)
+					return Remove(object, oldPos, oldSize, maxSize);
+				if (children) {
+					bool removed = false;
+					for (int i = 0; i < 4; ++i)
+						removed |= children[i].Update(object, oldPos, oldSize, newPos, newSize, depthLeft - 1, maxSize, handle);
+					if (removed)
+						Merge(maxSize);
+					return removed;
+				}
+				for (auto& i : contents) {
+					if (i.object == object) {
+						i.pos	= newPos;
+						i.size	= newSize;
+						break;
+					}
+				}
+				return false;
+			}
+
+			// if the children are all leaves and between them hold few enough objects, turn this back into a leaf
+			void Merge(int maxSize) {
+				if (!children)
+					return;
+				std::list< QuadTreeEntry<T> > merged;
+				for (int i = 0; i < 4; ++i) {
+					if (children[i].children)
+						return;
+					for (const auto& j : children[i].contents) {
+						// objects spanning children will be in more than one of them
+						bool found = false;
+						for (const auto& k : merged) {
+							if (k.object == j.object) {
+								found = true;
+								break;
+							}
+						}
+						if (found)
+							continue;
+						merged.push_back(j);
+						if ((int)merged.size() > maxSize)
+							return;
+					}
+				}
+				delete[] children;
+				children = nullptr;
+				contents.swap(merged);
+			}
+
+			// calls func on the entries of every leaf that passes the test, if the entry passes it too
+			void OperateOnBounds(QuadTreeBoundsFunc& test, QuadTreeEntryFunc& func) {
+				if (!test(Vector3(position.x, 0, position.y), Vector3(size.x, 1000.0f, size.y)))
+					return;
+				if (children)
+					for (int i = 0; i < 4; ++i)
+						children[i].OperateOnBounds(test, func);
+				else
+					for (auto& i : contents)
+						if (test(i.pos, i.size))
+							func(i);
+			}
+
+			/*
+			Children are visited nearest first, and any that start further along the ray than
+			maxDistance are skipped. func can bring maxDistance in whenever it finds a hit, so
+			once something close has been hit, the rest of the tree gets ignored.
+			*/
+			void OperateOnRay(const Ray& r, float& maxDistance, QuadTreeRayEntryFunc& func) {
+				float t;
+				if (!children) {
+					for (auto& i : contents)
+						if (RayBoundsTest(r, i.pos, i.size, t) && t <= maxDistance)
+							func(i, maxDistance);
+					return;
+				}
+				float	childT[4];
+				int		order[4];
+				int		count = 0;
+				for (int i = 0; i < 4; ++i) {
+					QuadTreeNode<T>& c = children[i];
+					if (!RayBoundsTest(r, Vector3(c.position.x, 0, c.position.y), Vector3(c.size.x, 1000.0f, c.size.y), t) || t > maxDistance)
+						continue;
+					// insertion sort, there's only ever 4 of them
+					int j = count++;
+					for (; j > 0 && childT[j - 1] > t; --j) {
+						childT[j]	= childT[j - 1];
+						order[j]	= order[j - 1];
+					}
+					childT[j]	= t;
+					order[j]	= i;
+				}
+				for (int i = 0; i < count; ++i) {
+					if (childT[i] > maxDistance)
+						break;
+					children[order[i]].OperateOnRay(r, maxDistance, func);
+				}
+			}
+
+			// slab test, which unlike RayBoxIntersection also works for rays starting inside the box
+			static bool RayBoundsTest(const Ray& r, const Vector3& boxPos, const Vector3& boxSize, float& tEnter) {
+				Vector3 rayPos = r.GetPosition();
+				Vector3 rayDir = r.GetDirection();
+				float tMin = 0.0f;
+				float tMax = FLT_MAX;
+				for (int i = 0; i < 3; ++i) {
+					if (rayDir[i] == 0.0f) {
+						if (abs(rayPos[i] - boxPos[i]) > boxSize[i])
+							return false;
+						continue;
+					}
+					float t1 = (boxPos[i] - boxSize[i] - rayPos[i]) / rayDir[i];
+					float t2 = (boxPos[i] + boxSize[i] - rayPos[i]) / rayDir[i];
+					if (t1 > t2)
+						std::swap(t1, t2);
+					tMin = std::max(tMin, t1);
+					tMax = std::min(tMax, t2);
+					if (tMin > tMax)
+						return false;
+				}
+				tEnter = tMin;
+				return true;
+			}
+
 			// split node into 4 child nodes that fill the same area of original node
 			void Split() {
 				Vector2 halfSize = size / 2.0f;		// * 0.5f??
@@ -90,6 +273,20 @@ namespace NCL {
 						func(contents);
 			}
 
+			// calls func on every entry whose AABB overlaps the given one. entries spanning
+			// multiple leaves will be visited once per leaf
+			void OperateOnOverlapping(const Vector3& objectPos, const Vector3& objectSize, QuadTreeEntryFunc& func) {
+				if (!Overlaps(objectPos, objectSize))
+					return;
+				if (children)
+					for (int i = 0; i < 4; ++i)
+						children[i].OperateOnOverlapping(objectPos, objectSize, func);
+				else
+					for (auto& i : contents)
+						if (CollisionDetection::AABBTest(objectPos, i.pos, objectSize, i.size))
+							func(i);
+			}
+
 		protected:
 			std::list< QuadTreeEntry<T> >	contents;
 
@@ -109,6 +306,9 @@ namespace NCL {
 		class QuadTree
 		{
 		public:
+			// called with each object the ray might hit, nearest first. Do the real test, and if it hits, set the float to the hit distance
+			typedef std::function<void(T, float&)> QuadTreeRayFunc;
+
 			QuadTree(Vector2 size, int maxDepth = 6, int maxSize = 5){
 				root = QuadTreeNode<T>(Vector2(), size);
 				this->maxDepth	= maxDepth;
@@ -117,8 +317,81 @@ namespace NCL {
 			~QuadTree() {
 			}
 
-			void Insert(T object, const Vector3& pos, const Vector3& size) {
-				root.Insert(object, pos, size, maxDepth, maxSize);
+			// room for this many more objects without the handle list growing as they go in
+			void Reserve(size_t count) {
+				if (count > freeHandles.size()) {
+					handles.reserve(handles.size() + count - freeHandles.size());
+				}
+			}
+
+			QuadTreeHandle Insert(T object, const Vector3& pos, const Vector3& size) {
+				QuadTreeHandle handle;
+				if (freeHandles.empty()) {
+					handle.index = (int)handles.size();
+					handles.emplace_back(HandleData());
+				}
+				else {
+					handle.index = freeHandles.back();
+					freeHandles.pop_back();
+				}
+				HandleData& data = handles[handle.index];
+				data.object = object;
+				data.pos	= pos;
+				data.size	= size;
+				data.inUse	= true;
+
+				InsertEntry(object, pos, size, handle.index);
+				return handle;
+			}
+
+			void Remove(QuadTreeHandle handle) {
+				if (!IsHandleInUse(handle))
+					return;
+				HandleData& data = handles[handle.index];
+				RemoveEntry(data.object, data.pos, data.size, handle.index);
+				data.inUse = false;
+				freeHandles.emplace_back(handle.index);
+			}
+
+			// has to search for the object's handle, so use the handle version if you have it
+			bool Remove(T object) {
+				QuadTreeHandle handle = FindHandle(object);
+				Remove(handle);
+				return handle.IsValid();
+			}
+
+			void Update(QuadTreeHandle handle, const Vector3& newPos, const Vector3& newSize) {
+				if (!IsHandleInUse(handle))
+					return;
+				HandleData& data = handles[handle.index];
+				if (data.pos == newPos && data.size == newSize)
+					return;
+				bool wasInside	= root.Contains(data.pos, data.size);
+				bool isInside	= root.Contains(newPos, newSize);
+				if (wasInside && isInside) {
+					root.Update(data.object, data.pos, data.size, newPos, newSize, maxDepth, maxSize, handle.index);
+				}
+				else if (!wasInside && !isInside) {
+					for (auto& i : outside) {
+						if (i.handle == handle.index) {
+							i.pos	= newPos;
+							i.size	= newSize;
+							break;
+						}
+					}
+				}
+				else {
+					RemoveEntry(data.object, data.pos, data.size, handle.index);
+					InsertEntry(data.object, newPos, newSize, handle.index);
+				}
+				data.pos	= newPos;
+				data.size	= newSize;
+			}
+
+			bool Update(T object, const Vector3& newPos, const Vector3& newSize) {
+				QuadTreeHandle handle = FindHandle(object);
+				Update(handle, newPos, newSize);
+				return handle.IsValid();
 			}
 
 			void DebugDraw() {
@@ -127,12 +400,126 @@ namespace NCL {
 
 			void OperateOnContents(typename QuadTreeNode<T>::QuadTreeFunc  func) {
 				root.OperateOnContents(func);
+				if (!outside.empty())
+					func(outside);
+			}
+
+			void OperateOnOverlapping(const Vector3& pos, const Vector3& size, typename QuadTreeNode<T>::QuadTreeEntryFunc func) {
+				for (auto& i : outside)
+					if (CollisionDetection::AABBTest(pos, i.pos, size, i.size))
+						func(i);
+				root.OperateOnOverlapping(pos, size, func);
+			}
+
+			/*
+			The queries only visit nodes that overlap the query shape. Objects spanning multiple
+			leaves are only reported once - each handle is stamped with the current query number
+			the first time it's seen. Objects that aren't wholly inside the tree's bounds are
+			tested every time, as no node can stand in for them.
+			*/
+			void QueryAABB(const Vector3& pos, const Vector3& size, std::vector<T>& results) {
+				QueryBounds([&](const Vector3& boundsPos, const Vector3& boundsSize) {
+					return CollisionDetection::AABBTest(pos, boundsPos, size, boundsSize);
+				}, results);
+			}
+
+			void QuerySphere(const Vector3& centre, float radius, std::vector<T>& results) {
+				QueryBounds([&](const Vector3& boundsPos, const Vector3& boundsSize) {
+					Vector3 delta = centre - boundsPos;
+					Vector3 closest = Maths::Clamp(delta, -boundsSize, boundsSize);
+					return (delta - closest).LengthSquared() < radius * radius;
+				}, results);
+			}
+
+			void QueryFrustum(const Frustum& frustum, std::vector<T>& results) {
+				QueryBounds([&](const Vector3& boundsPos, const Vector3& boundsSize) {
+					return frustum.AABBInsideFrustum(boundsPos, boundsSize);
+				}, results);
+			}
+
+			void QueryRay(const Ray& r, QuadTreeRayFunc func, float maxDistance = FLT_MAX) {
+				queryStamp++;
+				float t;
+				for (auto& i : outside)
+					if (QuadTreeNode<T>::RayBoundsTest(r, i.pos, i.size, t) && t <= maxDistance)
+						func(i.object, maxDistance);
+				if (!QuadTreeNode<T>::RayBoundsTest(r, Vector3(root.position.x, 0, root.position.y), Vector3(root.size.x, 1000.0f, root.size.y), t))
+					return;
+				typename QuadTreeNode<T>::QuadTreeRayEntryFunc visit = [&](QuadTreeEntry<T>& entry, float& distance) {
+					if (FirstVisit(entry))
+						func(entry.object, distance);
+				};
+				root.OperateOnRay(r, maxDistance, visit);
 			}
 
 		protected:
+			struct HandleData {
+				T		object;
+				Vector3 pos;
+				Vector3 size;
+				bool	inUse = false;
+				unsigned int stamp = 0;
+			};
+
+			void QueryBounds(typename QuadTreeNode<T>::QuadTreeBoundsFunc test, std::vector<T>& results) {
+				queryStamp++;
+				typename QuadTreeNode<T>::QuadTreeEntryFunc visit = [&](QuadTreeEntry<T>& entry) {
+					if (FirstVisit(entry))
+						results.emplace_back(entry.object);
+				};
+				for (auto& i : outside)
+					if (test(i.pos, i.size))
+						results.emplace_back(i.object);
+				root.OperateOnBounds(test, visit);
+			}
+
+			// anything not wholly inside the tree's bounds is kept out of the nodes altogether
+			void InsertEntry(T object, const Vector3& pos, const Vector3& size, int handle) {
+				if (root.Contains(pos, size))
+					root.Insert(object, pos, size, maxDepth, maxSize, handle);
+				else
+					outside.push_back(QuadTreeEntry<T>(object, pos, size, handle));
+			}
+
+			void RemoveEntry(const T& object, const Vector3& pos, const Vector3& size, int handle) {
+				if (root.Contains(pos, size))
+					root.Remove(object, pos, size, maxSize);
+				else
+					outside.remove_if([&](const QuadTreeEntry<T>& e) { return e.handle == handle; });
+			}
+
+			bool FirstVisit(const QuadTreeEntry<T>& entry) {
+				if (entry.handle < 0)
+					return true;
+				if (handles[entry.handle].stamp == queryStamp)
+					return false;
+				handles[entry.handle].stamp = queryStamp;
+				return true;
+			}
+
+			bool IsHandleInUse(QuadTreeHandle handle) const {
+				return handle.IsValid() && handle.index < (int)handles.size() && handles[handle.index].inUse;
+			}
+
+			QuadTreeHandle FindHandle(const T& object) const {
+				QuadTreeHandle handle;
+				for (int i = 0; i < (int)handles.size(); ++i) {
+					if (handles[i].inUse && handles[i].object == object) {
+						handle.index = i;
+						break;
+					}
+				}
+				return handle;
+			}
+
 			QuadTreeNode<T> root;
+			std::list< QuadTreeEntry<T> > outside;
 			int maxDepth;
 			int maxSize;
+
+			std::vector<HandleData> handles;
+			std::vector<int>		freeHandles;
+			unsigned int			queryStamp = 0;
 		};
 	}
 }
\ No newline at end of file
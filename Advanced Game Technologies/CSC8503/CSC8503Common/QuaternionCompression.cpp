@@ -0,0 +1,58 @@
+#include "QuaternionCompression.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	const float COMPONENT_RANGE = 0.70710678f;	// 1 / sqrt(2)
+}
+
+uint32_t QuaternionCompression::Compress(const Quaternion& q, int componentBits) {
+	Quaternion n = q;
+	n.Normalise();
+
+	int largest = 0;
+	for (int i = 1; i < 4; ++i) {
+		if (std::fabs(n.array[i]) > std::fabs(n.array[largest])) {
+			largest = i;
+		}
+	}
+	float sign = n.array[largest] < 0.0f ? -1.0f : 1.0f;
+
+	uint32_t maxValue	= (1u << componentBits) - 1;
+	uint32_t packed		= (uint32_t)largest;
+	int shift			= 2;
+	for (int i = 0; i < 4; ++i) {
+		if (i == largest) {
+			continue;
+		}
+		float v = std::min(std::max(n.array[i] * sign, -COMPONENT_RANGE), COMPONENT_RANGE);
+		uint32_t value = (uint32_t)std::lround((v + COMPONENT_RANGE) / (2.0f * COMPONENT_RANGE) * maxValue);
+		packed |= value << shift;
+		shift	+= componentBits;
+	}
+	return packed;
+}
+
+Quaternion QuaternionCompression::Decompress(uint32_t packed, int componentBits) {
+	int largest			= (int)(packed & 3);
+	uint32_t maxValue	= (1u << componentBits) - 1;
+	int shift			= 2;
+
+	Quaternion q;
+	float total = 0.0f;
+	for (int i = 0; i < 4; ++i) {
+		if (i == largest) {
+			continue;
+		}
+		uint32_t value = (packed >> shift) & maxValue;
+		q.array[i] = (value / (float)maxValue) * (2.0f * COMPONENT_RANGE) - COMPONENT_RANGE;
+		total	+= q.array[i] * q.array[i];
+		shift	+= componentBits;
+	}
+	q.array[largest] = std::sqrt(std::max(1.0f - total, 0.0f));	// rounding can push the others just past 1
+	q.Normalise();
+	return q;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "../../Common/Quaternion.h"
+#include <cstdint>
+
+namespace NCL {
+	using namespace Maths;
+	namespace CSC8503 {
+		/*
+		'Smallest three' packing of unit quaternions. The biggest component is left out,
+		as it can be worked back out from the other three (x^2 + y^2 + z^2 + w^2 = 1), and
+		those three can't be bigger than 1/sqrt(2), so their bits all go on that range.
+		2 bits say which one was left out, making 2 + 3 * componentBits in all - 10 bits
+		each fits it into a uint32_t.
+
+		q and -q are the same rotation, so it's flipped if need be to make the left out
+		component positive - it never needs a sign bit, and the same rotation always
+		packs to the same value.
+		*/
+		class QuaternionCompression {
+		public:
+			static const int DEFAULT_COMPONENT_BITS = 10;
+
+			static int TotalBits(int componentBits) {
+				return 2 + 3 * componentBits;
+			}
+
+			// componentBits can be 1 to 10
+			static uint32_t Compress(const Quaternion& q, int componentBits = DEFAULT_COMPONENT_BITS);
+			// always gives back a unit quaternion
+			static Quaternion Decompress(uint32_t packed, int componentBits = DEFAULT_COMPONENT_BITS);
+		};
+	}
+}
@@ -3,6 +3,7 @@
 #include "../../Common/TextureBase.h"
 #include "../../Common/ShaderBase.h"
 #include "../../Common/Vector4.h"
+#include "ComponentPool.h"
 
 namespace NCL {
 	using namespace NCL::Rendering;
@@ -12,7 +13,7 @@ namespace NCL {
 		class Transform;
 		using namespace Maths;
 
-		class RenderObject
+		class RenderObject : public PooledComponent<RenderObject>
 		{
 		public:
 			RenderObject(Transform* parentTransform, MeshGeometry* mesh, TextureBase* tex, ShaderBase* shader, Vector4 colour = Vector4(1.0f, 1.0f, 1.0f, 1.0f));
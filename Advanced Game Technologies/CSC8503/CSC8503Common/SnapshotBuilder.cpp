@@ -0,0 +1,89 @@
+#include "SnapshotBuilder.h"
+#include <cstring>
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	// object packets are kept 4 byte aligned within a snapshot
+	int PaddedSize(int size) {
+		return (size + 3) & ~3;
+	}
+}
+
+SnapshotBuilder::SnapshotBuilder(SendFunc send, int maxPacketSize) : send(send) {
+	buffer.resize(maxPacketSize);
+	used = sizeof(SnapshotPacket);
+}
+
+void SnapshotBuilder::Begin(int newTick) {
+	tick			= newTick;
+	objectCount		= 0;
+	packetsThisTick	= 0;
+	used			= sizeof(SnapshotPacket);
+}
+
+bool SnapshotBuilder::Add(const GamePacket& p) {
+	int size = PaddedSize(p.GetTotalSize());
+	if (size > MAX_OBJECT_PACKET || size > (int)buffer.size() - (int)sizeof(SnapshotPacket)) {
+		return false;
+	}
+	if (used + size > (int)buffer.size()) {
+		Flush();
+	}
+	memcpy(&buffer[used], &p, p.GetTotalSize());
+	used += size;
+	objectCount++;
+	return true;
+}
+
+void SnapshotBuilder::End() {
+	Flush();
+}
+
+void SnapshotBuilder::Flush() {
+	if (objectCount == 0) {
+		return;
+	}
+	SnapshotPacket header;
+	header.tick			= tick;
+	header.objectCount	= objectCount;
+	header.size			= (short)(used - sizeof(GamePacket));
+	memcpy(buffer.data(), &header, sizeof(SnapshotPacket));
+
+	send(*(GamePacket*)buffer.data());
+	packetsThisTick++;
+
+	objectCount	= 0;
+	used		= sizeof(SnapshotPacket);
+}
+
+bool SnapshotBuilder::Unpack(const GamePacket& snapshot, const ObjectFunc& f) {
+	int totalSize = snapshot.GetTotalSize();
+	if (snapshot.type != Snapshot || totalSize < (int)sizeof(SnapshotPacket)) {
+		return false;
+	}
+	const SnapshotPacket& header = (const SnapshotPacket&)snapshot;
+	int tick		= header.tick;
+	int objectCount	= header.objectCount;
+
+	const char* data	= (const char*)&snapshot;
+	int			at		= sizeof(SnapshotPacket);
+	alignas(16) char scratch[MAX_OBJECT_PACKET];
+
+	for (int i = 0; i < objectCount; ++i) {
+		if (at + (int)sizeof(GamePacket) > totalSize) {
+			return false;
+		}
+		memcpy(scratch, data + at, sizeof(GamePacket));
+		int size = ((const GamePacket*)scratch)->GetTotalSize();
+		// size comes off the wire, so it could be anything - even negative
+		if (size < (int)sizeof(GamePacket) || size > MAX_OBJECT_PACKET || at + size > totalSize) {
+			return false;
+		}
+		memcpy(scratch, data + at, size);
+		f(tick, *(GamePacket*)scratch);
+		at += PaddedSize(size);
+	}
+	return true;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "NetworkBase.h"
+#include <vector>
+#include <functional>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		The header of a Snapshot packet. It's followed by objectCount object packets
+		(FullPacket, DeltaPacket...) packed one after another, each with its own GamePacket
+		header so the reader knows how big it is.
+		*/
+		struct SnapshotPacket : public GamePacket {
+			int		tick		= 0;
+			short	objectCount	= 0;
+
+			SnapshotPacket() {
+				type = Snapshot;
+				size = sizeof(SnapshotPacket) - sizeof(GamePacket);
+			}
+		};
+
+		/*
+		Packs every replicated object's packet for a server tick into as few network packets
+		as possible, rather than sending (and allocating) one per object. Objects are added
+		to a buffer that's kept from tick to tick, and whenever the next one won't fit in
+		maxPacketSize, what's there so far is sent as one Snapshot packet.
+		*/
+		class SnapshotBuilder {
+		public:
+			typedef std::function<void(GamePacket&)>			SendFunc;
+			typedef std::function<void(int tick, GamePacket&)>	ObjectFunc;
+
+			// biggest object packet that can go in a snapshot
+			static const int MAX_OBJECT_PACKET = 256;
+
+			// 1200 bytes leaves room for the UDP and ENet headers in a typical 1400ish byte MTU
+			SnapshotBuilder(SendFunc send, int maxPacketSize = 1200);
+
+			void Begin(int tick);
+			// false if the packet's too big to ever fit
+			bool Add(const GamePacket& p);
+			void End();
+
+			int GetTick() const {
+				return tick;
+			}
+
+			// how many network packets the last tick took
+			int GetPacketsLastTick() const {
+				return packetsThisTick;
+			}
+
+			/*
+			Calls f with each object packet in a snapshot. They're copied out first, so f
+			can treat them as properly aligned FullPackets etc - but only as many bytes as
+			each says it has, so f has to check that's enough for its type. False if it isn't
+			a snapshot, or it's been cut short. The snapshot itself has to have arrived
+			whole (see NetworkBase::IsWholePacket).
+			*/
+			static bool Unpack(const GamePacket& snapshot, const ObjectFunc& f);
+
+		protected:
+			void Flush();
+
+			SendFunc			send;
+			std::vector<char>	buffer;
+			int					used			= 0;
+			int					tick			= 0;
+			short				objectCount		= 0;
+			int					packetsThisTick	= 0;
+		};
+	}
+}
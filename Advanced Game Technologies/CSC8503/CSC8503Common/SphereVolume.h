@@ -2,7 +2,7 @@
 #include "CollisionVolume.h"
 
 namespace NCL {
-	class SphereVolume : CollisionVolume
+	class SphereVolume : CollisionVolume, public CSC8503::PooledComponent<SphereVolume>
 	{
 	public:
 		SphereVolume(float sphereRadius = 1.0f) {
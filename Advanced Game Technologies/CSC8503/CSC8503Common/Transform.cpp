@@ -1,36 +1,87 @@
 #include "Transform.h"
+#include <algorithm>
 
 using namespace NCL::CSC8503;
 
 Transform::Transform()
 {
 	parent		= nullptr;
-	localScale	= Vector3(1, 1, 1);
+	localScale		= Vector3(1, 1, 1);
+	dirty			= true;
 }
 
 Transform::Transform(const Vector3& position, Transform* p) {
-	parent = p;
+	parent			= nullptr;
+	dirty			= true;
+	SetParent(p);
 	SetWorldPosition(position);
 }
 
+Transform::Transform(const Transform& other) {
+	*this = other;
+}
+
+Transform& Transform::operator=(const Transform& other) {
+	localMatrix			= other.localMatrix;
+	worldMatrix			= other.worldMatrix;
+	localPosition		= other.localPosition;
+	localScale			= other.localScale;
+	localOrientation	= other.localOrientation;
+	worldOrientation	= other.worldOrientation;
+	parent				= other.parent;
+	dirty				= other.dirty;
+	positionVersion		= other.positionVersion;
+	orientationVersion	= other.orientationVersion;
+	return *this;
+}
+
 Transform::~Transform()
 {
+	if (parent) {
+		parent->children.erase(std::remove(parent->children.begin(), parent->children.end(), this), parent->children.end());
+	}
+	for (Transform* c : children) {
+		c->parent = nullptr;
+		c->dirty = true;
+	}
+	if (parent || !children.empty()) {
+		HierarchyVersion()++;
+	}
+}
+
+void Transform::SetParent(Transform* newParent) {
+	if (newParent == parent) {
+		return;
+	}
+	if (parent) {
+		parent->children.erase(std::remove(parent->children.begin(), parent->children.end(), this), parent->children.end());
+	}
+	parent = newParent;
+	if (parent) {
+		parent->children.emplace_back(this);
+	}
+	dirty = true;
+	HierarchyVersion()++;
 }
 
+/*
+Builds the local matrix straight from position / orientation / scale, and as every
+transform is affine, the world matrix only needs the top three rows multiplying.
+Parents have to be updated before their children - GameWorld keeps its transforms
+in that order, and only calls this for ones that are dirty or have a changed parent.
+*/
 void Transform::UpdateMatrices() {
-	localMatrix = 
-		Matrix4::Translation(localPosition) * 
-		Matrix4(localOrientation) *
-		Matrix4::Scale(localScale);
+	localMatrix = Matrix4::FromTRS(localPosition, localOrientation, localScale);
 
 	if (parent) {
-		worldMatrix			= parent->GetWorldMatrix() * localMatrix;
+		worldMatrix			= Matrix4::AffineMultiply(parent->GetWorldMatrix(), localMatrix);
 		worldOrientation	= parent->GetWorldOrientation() * localOrientation;
 	}
 	else {
 		worldMatrix			= localMatrix;
 		worldOrientation	= localOrientation;
 	}
+	dirty			= false;
 }
 
 void Transform::SetWorldPosition(const Vector3& worldPos) {
@@ -46,10 +97,14 @@ void Transform::SetWorldPosition(const Vector3& worldPos) {
 
 		worldMatrix.SetPositionVector(worldPos);
 	}
+	dirty = true;
+	positionVersion++;
 }
 
 void Transform::SetLocalPosition(const Vector3& localPos) {
-	localPosition = localPos;
+	localPosition	= localPos;
+	dirty			= true;
+	positionVersion++;
 }
 
 void Transform::SetWorldScale(const Vector3& worldScale) {
@@ -59,8 +114,10 @@ void Transform::SetWorldScale(const Vector3& worldScale) {
 	else {
 		localScale = worldScale;
 	}
+	dirty = true;
 }
 
 void Transform::SetLocalScale(const Vector3& newScale) {
-	localScale = newScale;
+	localScale	= newScale;
+	dirty		= true;
 }
\ No newline at end of file
@@ -17,6 +17,9 @@ namespace NCL {
 		public:
 			Transform();
 			Transform(const Vector3& position, Transform* parent = nullptr);
+			// copies don't get added to the parent's children, and don't take the children with them
+			Transform(const Transform& other);
+			Transform& operator=(const Transform& other);
 			~Transform();
 
 			void SetWorldPosition(const Vector3& worldPos);
@@ -29,8 +32,15 @@ namespace NCL {
 				return parent;
 			}
 
-			void SetParent(Transform* newParent) {
-				parent = newParent;
+			void SetParent(Transform* newParent);
+
+			const vector<Transform*>& GetChildren() const {
+				return children;
+			}
+
+			// goes up whenever any transform's parent changes, so a cached hierarchy knows to rebuild
+			static int GetHierarchyVersion() {
+				return HierarchyVersion();
 			}
 
 			Matrix4 GetWorldMatrix() const {
@@ -58,7 +68,9 @@ namespace NCL {
 			}
 
 			void SetLocalOrientation(const Quaternion& newOr) {
-				localOrientation = newOr;
+				localOrientation	= newOr;
+				dirty				= true;
+				orientationVersion++;
 			}
 
 			Quaternion GetWorldOrientation() const {
@@ -69,9 +81,30 @@ namespace NCL {
 				return worldOrientation.Conjugate().ToMatrix3();
 			}
 
+			// has something local changed since the matrices were last updated? children of a
+			// dirty transform need updating too, even if they aren't dirty themselves
+			bool IsDirty() const {
+				return dirty;
+			}
+
 			void UpdateMatrices();
 
+			// go up every time the position or orientation is set, so threaded physics can tell
+			// whether the game has moved an object without having to compare floats
+			unsigned int GetPositionVersion() const {
+				return positionVersion;
+			}
+
+			unsigned int GetOrientationVersion() const {
+				return orientationVersion;
+			}
+
 		protected:
+			static int& HierarchyVersion() {
+				static int version = 0;
+				return version;
+			}
+
 			Matrix4		localMatrix;
 			Matrix4		worldMatrix;
 
@@ -83,6 +116,11 @@ namespace NCL {
 			Transform*	parent;
 
 			vector<Transform*> children;
+
+			bool		dirty;
+
+			unsigned int positionVersion	= 0;
+			unsigned int orientationVersion	= 0;
 		};
 	}
 }
@@ -0,0 +1,79 @@
+#include "WorkerPool.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+WorkerPool::WorkerPool(unsigned int threadCount) {
+	if (threadCount == 0) {
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+	}
+	for (unsigned int i = 0; i < threadCount; ++i) {
+		workers.emplace_back(&WorkerPool::WorkerLoop, this);
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	workReady.notify_all();
+	for (std::thread& t : workers) {
+		t.join();
+	}
+}
+
+void WorkerPool::ParallelFor(size_t count, const JobFunc& job) {
+	if (count == 0) {
+		return;
+	}
+	if (workers.empty() || count == 1) {
+		for (size_t i = 0; i < count; ++i) {
+			job(i);
+		}
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		currentJob		= &job;
+		jobCount		= count;
+		nextJob			= 0;
+		workersBusy		= (unsigned int)workers.size();
+		generation++;
+	}
+	workReady.notify_all();
+
+	RunJobs();
+
+	// every worker has to have let go of the job before it goes out of scope
+	std::unique_lock<std::mutex> lock(mutex);
+	workDone.wait(lock, [&]() { return workersBusy == 0; });
+	currentJob = nullptr;
+}
+
+void WorkerPool::RunJobs() {
+	for (size_t i = nextJob++; i < jobCount; i = nextJob++) {
+		(*currentJob)(i);
+	}
+}
+
+void WorkerPool::WorkerLoop() {
+	unsigned int seenGeneration = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			workReady.wait(lock, [&]() { return quit || generation != seenGeneration; });
+			if (quit) {
+				return;
+			}
+			seenGeneration = generation;
+		}
+		RunJobs();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			workersBusy--;
+		}
+		workDone.notify_one();
+	}
+}
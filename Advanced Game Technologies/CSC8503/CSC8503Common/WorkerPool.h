@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstddef>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A handful of threads that sit waiting for work, so we don't pay for starting
+		threads up every frame. ParallelFor hands out job indices to the workers and
+		the calling thread, and only returns once every job has finished - so jobs
+		can safely use anything on the caller's stack.
+
+		Only one ParallelFor can be running at once, and jobs mustn't call it themselves.
+		*/
+		class WorkerPool {
+		public:
+			typedef std::function<void(size_t)> JobFunc;
+
+			// 0 threads means pick one less than the number of hardware threads
+			WorkerPool(unsigned int threadCount = 0);
+			~WorkerPool();
+
+			void ParallelFor(size_t jobCount, const JobFunc& job);
+
+			// not counting the thread that calls ParallelFor
+			unsigned int GetThreadCount() const {
+				return (unsigned int)workers.size();
+			}
+
+		protected:
+			void WorkerLoop();
+			void RunJobs();
+
+			std::vector<std::thread>	workers;
+			std::mutex					mutex;
+			std::condition_variable		workReady;
+			std::condition_variable		workDone;
+
+			const JobFunc*		currentJob		= nullptr;
+			size_t				jobCount		= 0;
+			std::atomic<size_t>	nextJob			{ 0 };
+			unsigned int		generation		= 0;
+			unsigned int		workersBusy		= 0;
+			bool				quit			= false;
+		};
+	}
+}
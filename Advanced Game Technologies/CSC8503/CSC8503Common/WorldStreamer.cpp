@@ -0,0 +1,314 @@
+#include "WorldStreamer.h"
+#include "GameWorld.h"
+#include "../../Common/Assets.h"
+
+#include <fstream>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	const char		INDEX_MAGIC[4]	= { 'G', 'C', 'H', 'K' };
+	const uint32_t	INDEX_VERSION	= 1;
+
+	// how close something has to be to a moving object to count as holding it up (or in)
+	const float		SUPPORT_MARGIN	= 1.0f;
+
+	// an AABB's half size that covers the object whichever way round it is
+	Vector3 HalfSize(const LevelObject& o) {
+		switch (o.volumeType) {
+		case VolumeType::Sphere:
+			return Vector3(o.volumeSize.x, o.volumeSize.x, o.volumeSize.x);
+		case VolumeType::OBB: {
+			float r = o.volumeSize.Length();
+			return Vector3(r, r, r);
+		}
+		default:
+			return o.volumeSize;
+		}
+	}
+
+	bool Touches(const LevelObject& a, const LevelObject& b) {
+		Vector3 delta	= a.position - b.position;
+		Vector3 reach	= HalfSize(a) + HalfSize(b) + Vector3(SUPPORT_MARGIN, SUPPORT_MARGIN, SUPPORT_MARGIN);
+		return std::fabs(delta.x) <= reach.x && std::fabs(delta.y) <= reach.y && std::fabs(delta.z) <= reach.z;
+	}
+}
+
+WorldStreamer::WorldStreamer(GameWorld& world, const LevelAssets& assets) : world(world), assets(assets) {
+}
+
+WorldStreamer::~WorldStreamer() {
+	Close();
+}
+
+std::string WorldStreamer::ChunkFilename(const std::string& levelName, const ChunkCoord& c) {
+	return levelName + "_" + std::to_string(c.x) + "_" + std::to_string(c.z) + ".level";
+}
+
+std::string WorldStreamer::IndexFilename(const std::string& levelName) {
+	return levelName + ".chunks";
+}
+
+bool WorldStreamer::SaveChunks(LevelData& level, const std::string& levelName, float chunkSize) {
+	// anything that moves, or sits waiting to be picked up, needs whatever it's resting on or against
+	std::vector<const LevelObject*> dependants;
+	for (const LevelObject& o : level.objects) {
+		if (o.collectable || (o.hasPhysics && o.bodyType != BodyType::STATIC)) {
+			dependants.emplace_back(&o);
+		}
+	}
+
+	std::map<ChunkCoord, LevelData> split;
+	LevelData kept;
+	for (const LevelObject& o : level.objects) {
+		bool scenery = o.kind == 0 && !o.spawnPoint && !o.collectable &&
+			(!o.hasPhysics || o.bodyType == BodyType::STATIC);
+		Vector3 extent = o.volumeType == VolumeType::Sphere ? Vector3(o.volumeSize.x, 0, o.volumeSize.x) : o.volumeSize;
+		bool supporting = scenery && std::any_of(dependants.begin(), dependants.end(), [&](const LevelObject* d) {
+			return Touches(o, *d);
+		});
+		if (!scenery || supporting || std::max(extent.x, extent.z) > chunkSize * 0.5f) {
+			kept.objects.emplace_back(o);
+			continue;
+		}
+		ChunkCoord c;
+		c.x = (int)std::floor(o.position.x / chunkSize);
+		c.z = (int)std::floor(o.position.z / chunkSize);
+		split[c].objects.emplace_back(o);
+	}
+
+	for (auto& i : split) {
+		if (!LevelFile::Save(ChunkFilename(levelName, i.first), i.second)) {
+			return false;
+		}
+	}
+	std::ofstream index(Assets::DATADIR + IndexFilename(levelName), std::ios::binary);
+	uint32_t count = (uint32_t)split.size();
+	index.write(INDEX_MAGIC, 4);
+	index.write((const char*)&INDEX_VERSION, sizeof(INDEX_VERSION));
+	index.write((const char*)&chunkSize, sizeof(chunkSize));
+	index.write((const char*)&count, sizeof(count));
+	for (auto& i : split) {
+		int32_t coords[2] = { i.first.x, i.first.z };
+		index.write((const char*)coords, sizeof(coords));
+	}
+	if (!index) {
+		return false;
+	}
+	level = kept;
+	return true;
+}
+
+bool WorldStreamer::Open(const std::string& name, float newLoadRadius, float newUnloadRadius) {
+	Close();
+
+	std::ifstream index(Assets::DATADIR + IndexFilename(name), std::ios::binary);
+	char		magic[4]	= {};
+	uint32_t	version		= 0;
+	uint32_t	count		= 0;
+	index.read(magic, 4);
+	index.read((char*)&version, sizeof(version));
+	index.read((char*)&chunkSize, sizeof(chunkSize));
+	index.read((char*)&count, sizeof(count));
+	if (!index || memcmp(magic, INDEX_MAGIC, 4) != 0 || version != INDEX_VERSION || chunkSize <= 0.0f) {
+		return false;
+	}
+	chunks.clear();
+	for (uint32_t i = 0; i < count; ++i) {
+		int32_t coords[2];
+		if (!index.read((char*)coords, sizeof(coords))) {
+			chunks.clear();
+			return false;
+		}
+		ChunkCoord c;
+		c.x = coords[0];
+		c.z = coords[1];
+		chunks[c] = Chunk();
+	}
+	levelName		= name;
+	loadRadius		= newLoadRadius;
+	unloadRadius	= std::max(newLoadRadius, newUnloadRadius);	// or chunks would flicker in and out
+
+	quit = false;
+	loadThread = std::thread(&WorldStreamer::ThreadLoop, this);
+	return true;
+}
+
+void WorldStreamer::Close() {
+	if (!loadThread.joinable()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	requestReady.notify_all();
+	loadThread.join();
+
+	requests.clear();
+	results.clear();
+	Reset();
+	chunks.clear();
+}
+
+void WorldStreamer::Reset() {
+	for (auto& i : chunks) {
+		i.second = Chunk();
+	}
+	loadedChunks.clear();
+	std::lock_guard<std::mutex> lock(mutex);
+	requests.clear();
+	results.clear();	// still fine data, but they'll be asked for again if they're needed
+}
+
+// loading thread - only ever reads files, everything that touches the world happens in Update
+void WorldStreamer::ThreadLoop() {
+	while (true) {
+		ChunkCoord c;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			requestReady.wait(lock, [&]() { return quit || !requests.empty(); });
+			if (quit) {
+				return;
+			}
+			c = requests.front();
+			requests.pop_front();
+		}
+		LoadedChunk loaded;
+		loaded.coord = c;
+		LevelFile::Load(ChunkFilename(levelName, c), loaded.data);	// a missing chunk just comes back empty
+
+		std::lock_guard<std::mutex> lock(mutex);
+		results.emplace_back(std::move(loaded));
+	}
+}
+
+bool WorldStreamer::IsNear(const ChunkCoord& c, const std::vector<Vector3>& points, float radius) const {
+	for (const Vector3& p : points) {
+		// distance from the point to the nearest bit of the chunk's square
+		float dx = std::max(std::max(c.x * chunkSize - p.x, p.x - (c.x + 1) * chunkSize), 0.0f);
+		float dz = std::max(std::max(c.z * chunkSize - p.z, p.z - (c.z + 1) * chunkSize), 0.0f);
+		if (dx * dx + dz * dz <= radius * radius) {
+			return true;
+		}
+	}
+	return false;
+}
+
+template<class Func>
+void WorldStreamer::ForChunksNear(const std::vector<Vector3>& points, float radius, Func&& f) {
+	for (const Vector3& p : points) {
+		int minX = (int)std::floor((p.x - radius) / chunkSize);
+		int maxX = (int)std::floor((p.x + radius) / chunkSize);
+		int minZ = (int)std::floor((p.z - radius) / chunkSize);
+		int maxZ = (int)std::floor((p.z + radius) / chunkSize);
+		for (int x = minX; x <= maxX; ++x) {
+			for (int z = minZ; z <= maxZ; ++z) {
+				ChunkCoord c;
+				c.x = x;
+				c.z = z;
+				auto i = chunks.find(c);
+				if (i != chunks.end() && IsNear(c, points, radius)) {
+					f(i->first, i->second);
+				}
+			}
+		}
+	}
+}
+
+void WorldStreamer::Update(const std::vector<Vector3>& focusPoints) {
+	if (!IsOpen()) {
+		return;
+	}
+	// only chunks that were loaded can need unloading, so this never looks at the whole level
+	for (size_t i = 0; i < loadedChunks.size(); ) {
+		if (IsNear(loadedChunks[i], focusPoints, unloadRadius)) {
+			++i;
+			continue;
+		}
+		Unload(loadedChunks[i]);
+		loadedChunks[i] = loadedChunks.back();
+		loadedChunks.pop_back();
+	}
+
+	bool requested = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		ForChunksNear(focusPoints, loadRadius, [&](const ChunkCoord& c, Chunk& chunk) {
+			if (chunk.state == ChunkState::UNLOADED) {
+				chunk.state = ChunkState::QUEUED;
+				requests.emplace_back(c);
+				requested = true;
+			}
+		});
+	}
+	if (requested) {
+		requestReady.notify_one();
+	}
+
+	for (int i = 0; i < maxCommitsPerFrame; ++i) {
+		LoadedChunk loaded;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (results.empty()) {
+				break;
+			}
+			loaded = std::move(results.front());
+			results.pop_front();
+		}
+		Chunk& chunk = chunks[loaded.coord];
+		if (chunk.state != ChunkState::QUEUED) {
+			continue;	// reset while it was being read
+		}
+		if (!IsNear(loaded.coord, focusPoints, unloadRadius)) {
+			chunk.state = ChunkState::UNLOADED;	// everything's moved away while it was being read
+			continue;
+		}
+		Commit(loaded.coord, loaded.data);
+	}
+}
+
+void WorldStreamer::LoadNow(const std::vector<Vector3>& focusPoints) {
+	if (!IsOpen()) {
+		return;
+	}
+	ForChunksNear(focusPoints, loadRadius, [&](const ChunkCoord& c, Chunk& chunk) {
+		if (chunk.state == ChunkState::LOADED) {
+			return;
+		}
+		// anything already queued is built here instead, and ignored when the thread gets to it
+		LevelData data;
+		LevelFile::Load(ChunkFilename(levelName, c), data);
+		chunk.state = ChunkState::QUEUED;
+		Commit(c, data);
+	});
+}
+
+void WorldStreamer::Commit(const ChunkCoord& c, const LevelData& data) {
+	Chunk& chunk = chunks[c];
+	std::vector<GameObject*> built;
+	LevelFile::Build(data, world, assets, nullptr, &built);
+
+	chunk.objects.clear();
+	for (GameObject* o : built) {
+		chunk.objects.emplace_back(o->GetWorldHandle());
+	}
+	chunk.state = ChunkState::LOADED;
+	loadedChunks.emplace_back(c);
+}
+
+void WorldStreamer::Unload(const ChunkCoord& c) {
+	Chunk& chunk = chunks[c];
+	for (GameObjectHandle h : chunk.objects) {
+		if (GameObject* o = world.GetGameObject(h)) {
+			world.RemoveGameObject(o);
+		}
+	}
+	chunk.objects.clear();
+	chunk.state = ChunkState::UNLOADED;
+}
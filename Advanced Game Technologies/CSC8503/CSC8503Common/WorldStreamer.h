@@ -0,0 +1,141 @@
+#pragma once
+#include "LevelFile.h"
+#include "GameObject.h"
+#include <vector>
+#include <deque>
+#include <map>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace NCL {
+	namespace CSC8503 {
+		class GameWorld;
+
+		struct ChunkCoord {
+			int x = 0;
+			int z = 0;
+
+			bool operator<(const ChunkCoord& c) const {
+				return x != c.x ? x < c.x : z < c.z;
+			}
+		};
+
+		/*
+		Streams a level's static scenery in and out in square chunks, around a set of focus
+		points (the player, and any AI that needs the walls to be there). Each chunk is its
+		own level file, read on a background thread - but objects can only be made on the
+		game thread (see ComponentPool), so finished reads wait in a queue until Update
+		builds them into the world, a few at a time, between world updates.
+
+		Only the chunks near the focus points are ever in the world, so the broadphase and
+		the component pools only have to hold the area being played in, however big the
+		level is. Anything that moves, or that the game keeps a pointer to, stays in the
+		level file proper and is always loaded.
+
+		The navigation grid isn't streamed - it's one grid for the whole level, and AI
+		has to be able to plan paths through chunks that aren't loaded.
+		*/
+		class WorldStreamer {
+		public:
+			WorldStreamer(GameWorld& world, const LevelAssets& assets);
+			~WorldStreamer();
+
+			/*
+			Moves the scenery out of level and into chunk files named after levelName,
+			along with an index of which chunks there are. Scenery is anything without a
+			kind that doesn't move and isn't bigger than a chunk (a floor under the whole
+			level, say) - and that isn't touching anything that moves or can be collected,
+			so nothing's left resting on a platform that's been unloaded. Walls something
+			only reaches later are up to the game's focus points. If any file can't be
+			written, level is left alone.
+			*/
+			static bool SaveChunks(LevelData& level, const std::string& levelName, float chunkSize);
+
+			// reads levelName's chunk index and starts the loading thread. false if it's never been chunked
+			bool Open(const std::string& levelName, float loadRadius, float unloadRadius);
+			void Close();
+
+			bool IsOpen() const {
+				return loadThread.joinable();
+			}
+
+			/*
+			Call once a frame, before the world updates. Chunks within loadRadius of a focus
+			point are queued up to be read, chunks further than unloadRadius from all of them
+			are taken out of the world, and up to maxCommitsPerFrame chunks that have been
+			read are built into it.
+			*/
+			void Update(const std::vector<Vector3>& focusPoints);
+
+			// reads and builds everything near the focus points straight away, for a level's first frame
+			void LoadNow(const std::vector<Vector3>& focusPoints);
+
+			// forgets every chunk it's built, for once the world's been cleared
+			void Reset();
+
+			void SetMaxCommitsPerFrame(int count) {
+				maxCommitsPerFrame = count;
+			}
+
+			size_t GetLoadedChunkCount() const {
+				return loadedChunks.size();
+			}
+
+			size_t GetChunkCount() const {
+				return chunks.size();
+			}
+
+		protected:
+			enum class ChunkState {
+				UNLOADED,
+				QUEUED,		// waiting to be read, or read and waiting to be built
+				LOADED
+			};
+
+			struct Chunk {
+				ChunkState						state = ChunkState::UNLOADED;
+				std::vector<GameObjectHandle>	objects;
+			};
+
+			struct LoadedChunk {
+				ChunkCoord	coord;
+				LevelData	data;
+			};
+
+			static std::string ChunkFilename(const std::string& levelName, const ChunkCoord& c);
+			static std::string IndexFilename(const std::string& levelName);
+
+			void ThreadLoop();
+			void Commit(const ChunkCoord& c, const LevelData& data);
+			void Unload(const ChunkCoord& c);
+
+			// calls f with every chunk whose square is within radius of one of the points
+			template<class Func>
+			void ForChunksNear(const std::vector<Vector3>& points, float radius, Func&& f);
+
+			bool IsNear(const ChunkCoord& c, const std::vector<Vector3>& points, float radius) const;
+
+			GameWorld&			world;
+			const LevelAssets&	assets;
+
+			std::string	levelName;
+			float		chunkSize		= 0.0f;
+			float		loadRadius		= 0.0f;
+			float		unloadRadius	= 0.0f;
+			int			maxCommitsPerFrame = 1;
+
+			std::map<ChunkCoord, Chunk>	chunks;			// only the chunks the index says exist
+			std::vector<ChunkCoord>		loadedChunks;
+
+			// shared with the loading thread
+			std::thread					loadThread;
+			std::mutex					mutex;
+			std::condition_variable		requestReady;
+			std::deque<ChunkCoord>		requests;
+			std::deque<LoadedChunk>		results;
+			bool						quit = false;
+		};
+	}
+}
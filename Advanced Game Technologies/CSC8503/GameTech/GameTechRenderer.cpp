@@ -1,6 +1,7 @@
 #include "GameTechRenderer.h"
 #include "../CSC8503Common/GameObject.h"
 #include "../../Common/Camera.h"
+#include "../../Common/Frustum.h"
 #include "../../Common/Vector2.h"
 #include "../../Common/Vector3.h"
 using namespace NCL;
@@ -57,22 +58,39 @@ void GameTechRenderer::RenderFrame() {
 	glDisable(GL_CULL_FACE); //Todo - text indices are going the wrong way...
 }
 
+// the world keeps a packed array of the render objects of its active objects, so there's no need to visit every object
 void GameTechRenderer::BuildObjectList() {
-	std::vector<GameObject*>::const_iterator first;
-	std::vector<GameObject*>::const_iterator last;
-
-	gameWorld.GetObjectIterators(first, last);
+	const ComponentArray<RenderObject*>& renderObjects = gameWorld.GetRenderObjects();
 
 	activeObjects.clear();
+	activeObjects.insert(activeObjects.end(), renderObjects.begin(), renderObjects.end());
+}
 
-	for (std::vector<GameObject*>::const_iterator i = first; i != last; ++i) {
-		if ((*i)->IsActive()) {
-			const RenderObject*g = (*i)->GetRenderObject();
-			if (g) {
-				activeObjects.emplace_back(g);
-			}
+/*
+Everything goes in the shadow map, as objects behind the camera can still cast
+shadows into view, but only objects the world's quadtree says are inside the
+camera's frustum get drawn to the screen. Objects without a bounding volume
+aren't in the tree, so they're always drawn.
+*/
+void GameTechRenderer::BuildVisibleObjectList(const Matrix4& viewProj) {
+	Frustum frameFrustum;
+	frameFrustum.FromMatrix(viewProj);
+
+	visibleObjects.clear();
+	frustumQuery.clear();
+	gameWorld.GetQuadTree()->QueryFrustum(frameFrustum, frustumQuery);
+
+	for (GameObject* i : frustumQuery) {
+		if (i->IsActive() && i->GetRenderObject()) {
+			visibleObjects.emplace_back(i->GetRenderObject());
 		}
 	}
+
+	gameWorld.ForEachWith<RenderObject>([&](GameObject* o, RenderObject& r) {
+		if (o->GetWorldTreeHandle() < 0 && o->IsActive()) {
+			visibleObjects.emplace_back(&r);
+		}
+	});
 }
 
 void GameTechRenderer::SortObjectList() {
@@ -115,6 +133,8 @@ void GameTechRenderer::RenderCamera() {
 	Matrix4 viewMatrix = gameWorld.GetMainCamera()->BuildViewMatrix();
 	Matrix4 projMatrix = gameWorld.GetMainCamera()->BuildProjectionMatrix(screenAspect);
 
+	BuildVisibleObjectList(projMatrix * viewMatrix);
+
 	OGLShader* activeShader = nullptr;
 	int projLocation	= 0;
 	int viewLocation	= 0;
@@ -134,7 +154,7 @@ void GameTechRenderer::RenderCamera() {
 	glActiveTexture(GL_TEXTURE0 + 1);
 	glBindTexture(GL_TEXTURE_2D, shadowTex);
 
-	for (const auto&i : activeObjects) {
+	for (const auto&i : visibleObjects) {
 		OGLShader* shader = (OGLShader*)(*i).GetShader();
 		BindShader(shader);
 
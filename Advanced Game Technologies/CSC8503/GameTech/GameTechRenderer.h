@@ -25,6 +25,7 @@ namespace NCL {
 			GameWorld&	gameWorld;
 
 			void BuildObjectList();
+			void BuildVisibleObjectList(const Matrix4& viewProj);
 			void SortObjectList();
 			void RenderShadowMap();
 			void RenderCamera(); 
@@ -32,6 +33,8 @@ namespace NCL {
 			void SetupDebugMatrix(OGLShader*s) override;
 
 			vector<const RenderObject*> activeObjects;
+			vector<const RenderObject*> visibleObjects;	// activeObjects inside the camera's frustum
+			vector<GameObject*>			frustumQuery;
 
 			//shadow mapping things
 			OGLShader*	shadowShader;
@@ -2,37 +2,101 @@
 #include "NetworkPlayer.h"
 #include "../CSC8503Common/GameServer.h"
 #include "../CSC8503Common/GameClient.h"
+#include "../CSC8503Common/Debug.h"
 
 #define COLLISION_MSG 30
 
 void NetworkedGame::UpdateAsClient(float dt) {
 	ClientPacket newPacket;
+	newPacket.lastID = lastStateID;
 
 	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::SPACE)) {
 		newPacket.buttonstates[0] = 1;
-		// need to work this out...
-		newPacket.lastID = 0;
 	}
 	thisClient->SendPacket(newPacket);
 }
 
-void NetworkedGame::BroadcastSnapshot(bool deltaFrame) {
-	std::vector<GameObject*>::const_iterator first;
-	std::vector<GameObject*>::const_iterator last;
+void NetworkedGame::SendSnapshots(bool deltaFrame) {
+	if (!snapshot) {
+		snapshot.reset(new SnapshotBuilder([&](GamePacket& p) {
+			thisServer->SendPacketToPeer(snapshotPeer, p);
+		}));
+	}
+	if (!interest) {
+		interest.reset(new InterestManager(*world));
+		// the score needs to be right wherever the player is
+		interest->AddAlwaysRelevantRule([](GameObject& o) {
+			PhysicsObject* p = o.GetPhysicsObject();
+			return p && p->GetCollisionType() == CollisionType::COLLECTABLE;
+		});
+		interest->AddAlwaysRelevantRule([&](GameObject& o) {
+			for (auto& i : serverPlayers) {
+				if (i.second == &o) {
+					return true;
+				}
+			}
+			return false;
+		});
+	}
+	interest->BeginTick();
 
-	world->GetObjectIterators(first, last);
+	int tick = snapshotTick++;
+	for (auto& i : serverPlayers) {
+		snapshotPeer = i.first;
+		if (i.second) {
+			interest->GetRelevantObjects(i.second->GetTransform().GetWorldPosition(), relevantObjects);
+		}
+		else {
+			interest->GetAlwaysRelevantObjects(relevantObjects);
+		}
+		//nothing acked yet means there's nothing to delta against, so everything goes out full
+		auto state = stateIDs.find(snapshotPeer);
+		int playerState = state != stateIDs.end() ? state->second : -1;
 
-	for (auto i = first; i != last; ++i) {
-		NetworkObject* o = (*i)->GetNetworkObject();
-		if (!o)
-			continue;
+		snapshot->Begin(tick);
+		for (NetworkObject* o : relevantObjects) {
+			o->WritePacket(*snapshot, deltaFrame, playerState);
+		}
+		snapshot->End();
+	}
+	if (displayPoolStats) {
+		DisplayDeltaStats();
+	}
+}
 
-		// need to do this bit...
-		int playerState = 0;
-		GamePacket* newPacket = nullptr;
-		if (o->WritePacket(&newPacket, deltaFrame, playerState)) {
-			thisServer->SendGlobalPacket(*newPacket);
-			delete newPacket;
+// what deltas have cost and how far out they've left the clients, over every object
+void NetworkedGame::DisplayDeltaStats() {
+	DeltaStats total;
+	for (NetworkObject* o : networkObjects) {
+		if (o) {
+			total.Add(o->GetDeltaStats());
 		}
 	}
+	std::ostringstream line;
+	line << std::fixed << std::setprecision(2);
+	line << "Deltas:" << total.deltasWritten << " full:" << total.fullFallbacks << " bits:" << total.AverageBits();
+	Debug::Print(line.str(), Vector2(20, 100));
+
+	line.str("");
+	line << "Delta error:" << total.AveragePositionError() << "m/" << total.maxPositionError << "m "
+		<< total.AverageAngleError() << "deg/" << total.maxAngleError << "deg";
+	Debug::Print(line.str(), Vector2(20, 120));
+}
+
+void NetworkedGame::ReceivePacket(int type, GamePacket* payload, int source) {
+	if (type == Snapshot) {
+		SnapshotBuilder::Unpack(*payload, [&](int tick, GamePacket& p) {
+			int id = NetworkObject::GetPacketObjectID(p);
+			if (id >= 0 && id < (int)networkObjects.size() && networkObjects[id]) {
+				if (networkObjects[id]->ReadPacket(p) && p.type == Full_State) {
+					lastStateID = std::max(lastStateID, ((FullPacket&)p).stateID);
+				}
+			}
+		});
+	}
+	else if (type == Received_State && payload->GetTotalSize() >= (int)sizeof(ClientPacket)) {
+		//acks can arrive out of order, and deltas are only ever based on the newest
+		int& acked = stateIDs.emplace(source, -1).first->second;
+		acked = std::max(acked, ((ClientPacket*)payload)->lastID);
+	}
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
 #pragma once
 #include "TutorialGame.h"
+#include "../CSC8503Common/SnapshotBuilder.h"
+#include "../CSC8503Common/InterestManager.h"
+#include <memory>
 
 namespace NCL {
 	namespace CSC8503 {
@@ -29,16 +32,27 @@ namespace NCL {
 			void UpdateAsServer(float dt);
 			void UpdateAsClient(float dt);
 
-			void BroadcastSnapshot(bool deltaFrame);
+			// each client's snapshot only has the objects that are relevant to it
+			void SendSnapshots(bool deltaFrame);
+			void DisplayDeltaStats();
 			void UpdateMinimumState();
-			std::map<int, int> stateIDs;
+			std::map<int, int> stateIDs;	// the newest full state each client has acked
+			int lastStateID = -1;			// on a client, the newest full state it's got
 
 			GameServer* thisServer;
 			GameClient* thisClient;
 			float timeToNextPacket;
 			int packetsToSnapshot;
 
-			std::vector<NetworkObject*> networkObjects;
+			// every object's state for a tick goes out in as few Snapshot packets as possible
+			std::unique_ptr<SnapshotBuilder> snapshot;
+			int snapshotTick = 0;
+			int snapshotPeer = -1;	// who the snapshot being built is for
+
+			std::unique_ptr<InterestManager> interest;
+			std::vector<NetworkObject*> relevantObjects;
+
+			std::vector<NetworkObject*> networkObjects;	// indexed by network ID
 
 			std::map<int, GameObject*> serverPlayers;
 			GameObject* localPlayer;
@@ -6,6 +6,9 @@
 #include "../../Common/TextureLoader.h"
 
 #include "../CSC8503Common/PositionConstraint.h"
+#include <algorithm>
+#include <iterator>
+#include <iostream>
 
 using namespace NCL;
 using namespace CSC8503;
@@ -14,6 +17,7 @@ TutorialGame::TutorialGame()	{
 	world		= new GameWorld();
 	renderer	= new GameTechRenderer(*world);
 	physics		= new PhysicsSystem(*world);
+	streamer	= new WorldStreamer(*world, levelAssets);
 	stateMachine = new StateMachine();
 
 	forceMagnitude	= 10.0f;
@@ -22,6 +26,20 @@ TutorialGame::TutorialGame()	{
 	inSelectionMode = true;
 	enablePathfinding = false;
 
+	// stops the goose tunnelling through the thin walls without needing substeps
+	physics->UseSpeculativeContacts(true);
+	// platforms and trampolines sit above other objects, which a quadtree can't tell apart
+	world->SetBroadphaseStructure(BroadphaseStructure::OCTREE);
+
+	// don't hang on to objects the world has got rid of
+	world->AddRemovalCallback([&](GameObject* o) {
+		if (selectionObject == o)
+			selectionObject = nullptr;
+		if (lockedObject == o)
+			lockedObject = nullptr;
+	});
+	physics->SetCollectedCallback([&](GameObject* o) { OnCollected(o); });
+
 	Debug::SetRenderer(renderer);
 	
 	InitialiseAssets();
@@ -52,11 +70,66 @@ void TutorialGame::InitialiseAssets() {
 	basicTex	= (OGLTexture*)TextureLoader::LoadAPITexture("checkerboard.png");
 	basicShader = new OGLShader("GameTechVert.glsl", "GameTechFrag.glsl");
 
+	// the order's part of the level format, so only ever add to the end of these
+	levelAssets.meshes		= { cubeMesh, sphereMesh, gooseMesh, keeperMesh, appleMesh, charA, charB };
+	levelAssets.textures	= { basicTex };
+	levelAssets.shaders		= { basicShader };
+
+	InitPrototypes();
 	InitCamera();
 	InitWorld();
 	InitMisc();
 }
 
+// objects that come and go during the game are pooled by the world rather than made from scratch each time
+void TutorialGame::InitPrototypes() {
+	bonusPrototype	= world->RegisterPrototype([&]() { return CreateCube(Vector3(), Vector3(0.8, 0.8, 0.8), 10.0f, true); });
+	keeperPrototype	= world->RegisterPrototype([&]() {
+		GameObject* keeper = CreateParkKeeper(PARK_KEEPER_SPAWN);
+		SetLevelKind(keeper, EXTRA_KEEPER, true);
+		return keeper;
+	});
+}
+
+GameObjectHandle TutorialGame::SpawnBonusItem(const Vector3& position) {
+	GameObjectHandle handle = world->AcquireInstance(bonusPrototype, position);
+	GameObject* item = world->GetGameObject(handle);
+	item->SetSpawnPos(position);
+	item->SetCollected(false);
+	SetLevelKind(item, BONUS_ITEM, true);
+	return handle;
+}
+
+// anything that needs the walls and floors around it to be there - the moving blocks only turn round when they hit a wall
+void TutorialGame::GetStreamingFocus(std::vector<Vector3>& points) const {
+	points.emplace_back(goose->GetTransform().GetWorldPosition());
+	for (GameObject* i : world->GetObjectsOfType(CollisionType::AI))
+		points.emplace_back(i->GetTransform().GetWorldPosition());
+	for (int i = 0; i < dynamicCubeCount; ++i)
+		points.emplace_back(dynamicCube[i]->GetTransform().GetWorldPosition());
+}
+
+void TutorialGame::SetLevelKind(GameObject* o, LevelObjectKind kind, bool spawnPoint) {
+	o->AddComponent<LevelObjectKindComponent>(LevelObjectKindComponent{ kind, spawnPoint });
+}
+
+// apples are gone for good once picked up, bonus items go back to the pool until they're dropped
+void TutorialGame::OnCollected(GameObject* o) {
+	if (world->GetGameObject(o->GetWorldHandle()) != o)
+		return;	// already on its way out of the world
+	PrototypeInstanceComponent* instance = o->GetComponent<PrototypeInstanceComponent>();
+	if (instance && instance->prototype == bonusPrototype) {
+		bonusCount++;
+		collectedBonus.emplace_back(o->GetSpawnPos());
+		goose->SetHasBonusItem(true);
+		world->ReleaseInstance(o->GetWorldHandle());
+	}
+	else {
+		appleCount++;
+		world->RemoveGameObject(o);
+	}
+}
+
 TutorialGame::~TutorialGame()	{
 	delete cubeMesh;
 	delete sphereMesh;
@@ -66,6 +139,7 @@ TutorialGame::~TutorialGame()	{
 
 	delete physics;
 	delete renderer;
+	delete streamer;
 	delete world;
 	delete stateMachine;
 
@@ -75,11 +149,6 @@ TutorialGame::~TutorialGame()	{
 	delete lake;
 	delete gate;
 	delete parkKeeper;
-	delete[] spinner;
-	delete[] apple;
-	delete[] bonusItem;
-	delete[] dynamicCube;
-	delete[] trampoline;
 }
 
 void TutorialGame::UpdateGame(float dt) {
@@ -98,6 +167,21 @@ void TutorialGame::UpdateGame(float dt) {
 	else {
 		Debug::Print("(G)ravity off", Vector2(renderer->GetWidth() - 400, 20));
 	}
+	if (physics->IsThreaded()) {
+		Debug::Print("(T)hreaded physics on", Vector2(renderer->GetWidth() - 400, 40));
+	}
+	else {
+		Debug::Print("(T)hreaded physics off", Vector2(renderer->GetWidth() - 400, 40));
+	}
+	if (physics->UsingSpeculativeContacts()) {
+		Debug::Print("Spe(C)ulative contacts on", Vector2(renderer->GetWidth() - 400, 60));
+	}
+	else {
+		Debug::Print("Spe(C)ulative contacts off", Vector2(renderer->GetWidth() - 400, 60));
+	}
+	if (displayPoolStats) {
+		DisplayPoolStats();
+	}
 	/*if (useBroadPhase) {
 		Debug::Print("Broadphase on", Vector2(20, 60));
 	}
@@ -119,9 +203,14 @@ void TutorialGame::UpdateGame(float dt) {
 	goose->HasCollidedWith() == CollisionType::LAKE ? goose->GetPhysicsObject()->SetInverseMass(0.35f) : goose->GetPhysicsObject()->SetInverseMass(1.0f);
 	PlayerMovement();
 
+	std::vector<Vector3> focus;
+	GetStreamingFocus(focus);
+	streamer->Update(focus);
+
 	world->UpdateWorld(dt);
 	renderer->Update(dt);
 	physics->Update(dt);
+	world->UpdateBounds();	// the renderer culls against the quadtree, which physics has just left behind
 	stateMachine->Update();
 
 	updatePath += dt;
@@ -141,21 +230,6 @@ void TutorialGame::UpdateGame(float dt) {
 		ResetGame();
 	}
 
-	for (GameObject* i : apple) {
-		if (i->IsCollected()) {
-			appleCount++;
-			collectedApples.emplace_back(i);
-			i->SetCollected(false);
-		}
-	}
-	for (GameObject* i : bonusItem) {
-		if (i->IsCollected()) {
-			bonusCount++;
-			collectedBonus.emplace_back(i);
-			goose->SetHasBonusItem(true);
-			i->SetCollected(false);
-		}
-	}
 	if (goose->HasCollidedWith() == CollisionType::HOME && (appleCount > 0 || bonusCount > 0)) {
 		totalScore += appleCount;
 		totalScore += bonusCount * bonusValue;
@@ -163,8 +237,12 @@ void TutorialGame::UpdateGame(float dt) {
 		goose->SetHasBonusItem(false);
 		sentry->GetTransform().SetWorldPosition(SENTRY_SPAWN);
 		parkKeeper->GetTransform().SetWorldPosition(PARK_KEEPER_SPAWN);
-		collectedApples.clear();
 		collectedBonus.clear();
+		// banking sends the extra keepers away too
+		for (GameObjectHandle h : extraKeepers)
+			world->ReleaseInstance(h);
+		extraKeepers.clear();
+		keeperSpawnTimer = 0.0f;
 	}
 	if (goose->HasCollidedWith() == CollisionType::TRAMPOLINE) {
 		goose->SetCollidedWith(CollisionType::DEFAULT);
@@ -173,13 +251,13 @@ void TutorialGame::UpdateGame(float dt) {
 	if (goose->HasCollidedWith() == CollisionType::AI) {
 		goose->SetCollidedWith(CollisionType::DEFAULT);
 		goose->SetHasBonusItem(false);
-		for (GameObject* i : collectedBonus)
-			i->GetTransform().SetWorldPosition(i->GetSpawnPos());
+		for (const Vector3& i : collectedBonus)
+			SpawnBonusItem(i);
 		collectedBonus.clear();
 		bonusCount = 0;
 	}
 	// display selected object position, orientation and AI state... if any
-	if (displayObjectInfo) {
+	if (displayObjectInfo && selectionObject) {
 		std::ostringstream s;
 		s << selectionObject->GetTransform().GetWorldPosition();
 		renderer->DrawString(s.str(), Vector2(250, renderer->GetHeight() - 20));
@@ -190,31 +268,64 @@ void TutorialGame::UpdateGame(float dt) {
 		renderer->DrawString(selectionObject->GetStateDescription(), Vector2(390, renderer->GetHeight() - 60));
 	}
 
-	UpdateMovingBlocks();
-	for(GameObject* i : spinner)
-		i->GetPhysicsObject()->AddTorque(Vector3(0.0, 150000.0, 0.0));
+	UpdateMovingBlocks(dt);
+	for (int i = 0; i < spinnerCount; ++i)
+		spinner[i]->GetPhysicsObject()->AddTorque(Vector3(0.0, 150000.0, 0.0));
 
-	// @TODO spawn new keeper every 30 secs
+	UpdateExtraKeepers(dt);
 
 	Debug::FlushRenderables();
 	renderer->Render();
 }
 
-void TutorialGame::UpdateMovingBlocks() {
-	// move blocks. if they hit a wall, move in the other direction
-	if (dynamicCube[0]->HasCollidedWith() == CollisionType::WALL) {
-		cubeDirection[0] *= -1.0f;
-		dynamicCube[0]->SetCollidedWith(CollisionType::DEFAULT);
+// another park keeper joins the chase every 30 seconds, until the goose makes it home
+void TutorialGame::UpdateExtraKeepers(float dt) {
+	keeperSpawnTimer += dt;
+	if (keeperSpawnTimer >= keeperSpawnTime && extraKeepers.size() < maxExtraKeepers) {
+		extraKeepers.emplace_back(world->AcquireInstance(keeperPrototype, PARK_KEEPER_SPAWN));
+		keeperSpawnTimer = 0.0f;
+	}
+	for (GameObjectHandle h : extraKeepers) {
+		GameObject* keeper = world->GetGameObject(h);
+		if (!keeper)
+			continue;
+		Vector3 direction = goose->GetTransform().GetWorldPosition() - keeper->GetTransform().GetWorldPosition();
+		direction.y = 0.0f;
+		keeper->GetPhysicsObject()->AddForce(direction.Normalised() * 150.0f);
 	}
-	dynamicCube[0]->GetPhysicsObject()->AddForce(Vector3(-100000.0f * cubeDirection[0], 0.0f, 0.0f));
+}
 
-	for (int i = 1; i < 3; ++i) {
+void TutorialGame::UpdateMovingBlocks(float dt) {
+	// move blocks. if they hit a wall, move in the other direction
+	// blocks are kinematic, so they're moved to a target rather than pushed by forces
+	for (int i = 0; i < dynamicCubeCount; ++i) {
 		if (dynamicCube[i]->HasCollidedWith() == CollisionType::WALL) {
 			cubeDirection[i] *= -1.0f;
 			dynamicCube[i]->SetCollidedWith(CollisionType::DEFAULT);
 		}
-		dynamicCube[i]->GetPhysicsObject()->AddForce(Vector3(0.0f, 0.0f, 100000.0f * cubeDirection[i]));
+		Vector3 direction = i == 0 ? Vector3(-cubeDirection[i], 0.0f, 0.0f) : Vector3(0.0f, 0.0f, cubeDirection[i]);
+		Transform& transform = dynamicCube[i]->GetTransform();
+		dynamicCube[i]->GetPhysicsObject()->SetKinematicTarget(transform.GetWorldPosition() + direction * movingBlockSpeed * dt,
+			transform.GetLocalOrientation(), dt);
+	}
+}
+
+// live / peak / capacity for each component pool, plus anything that was too big to be pooled
+void TutorialGame::DisplayPoolStats() {
+	std::vector<ComponentPoolStats> stats;
+	ComponentPoolBase::GetAllStats(stats);
+	float y = 100;
+	for (const ComponentPoolStats& s : stats) {
+		std::ostringstream line;
+		line << s.name << ": " << s.liveCount << "/" << s.peakCount << "/" << s.capacity;
+		if (s.fallbackAllocations > 0) {
+			line << " heap:" << s.fallbackAllocations;
+		}
+		Debug::Print(line.str(), Vector2(renderer->GetWidth() - 400, y));
+		y += 20;
 	}
+	Debug::Print("Collectables:" + std::to_string(world->GetObjectsOfType(CollisionType::COLLECTABLE).size()) +
+		" AI:" + std::to_string(world->GetObjectsOfType(CollisionType::AI).size()), Vector2(renderer->GetWidth() - 400, y));
 }
 
 void TutorialGame::ResetGame() {
@@ -235,10 +346,23 @@ void TutorialGame::UpdateKeys() {
 		InitCamera(); //F2 will reset the camera to a specific default place
 	}
 
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::F3)) {
+		displayPoolStats = !displayPoolStats; //F3 shows how full the component pools are
+	}
+
 	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::G)) {
 		useGravity = !useGravity; //Toggle gravity!
 		physics->UseGravity(useGravity);
 	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::T)) {
+		if (physics->IsThreaded())
+			physics->StopThread();
+		else
+			physics->StartThread(physicsRate);
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::C)) {
+		physics->UseSpeculativeContacts(!physics->UsingSpeculativeContacts());
+	}
 	/*if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::B)) {
 		useBroadPhase = !useBroadPhase;
 		physics->UseBroadPhase(useBroadPhase);
@@ -274,7 +398,7 @@ void TutorialGame::UpdateKeys() {
 
 void TutorialGame::LockedObjectMovement() {
 	Matrix4 view		= world->GetMainCamera()->BuildViewMatrix();
-	Matrix4 camWorld	= view.Inverse();
+	Matrix4 camWorld	= view.InverseRigid();
 
 	Vector3 rightAxis = Vector3(camWorld.GetColumn(0)); //view is inverse of model!
 
@@ -310,7 +434,7 @@ void  TutorialGame::LockedCameraMovement() {
 
 		Matrix4 temp = Matrix4::BuildViewMatrix(camPos, objPos, Vector3(0, 1, 0));
 
-		Matrix4 modelMat = temp.Inverse();
+		Matrix4 modelMat = temp.InverseRigid();
 
 		Quaternion q(modelMat);
 		Vector3 angles = q.ToEuler(); //nearly there now!
@@ -403,7 +527,7 @@ void TutorialGame::PlayerMovement() {
 		}
 
 		// direction goose is facing
-		Vector3 directionVec = goose->GetTransform().GetWorldPosition() - goose->GetPhysicsObject()->GetAngularVelocity();
+		Vector3 directionVec = goose->GetTransform().GetWorldPosition() - physics->GetAngularVelocity(*goose);
 		directionVec.Normalise();
 		float gooseAngle = atan2(directionVec.x, directionVec.z);
 		Quaternion orientation = Quaternion(0.0f, sin(gooseAngle * 0.5f), 0.0f, cos(gooseAngle * 0.5f));
@@ -632,13 +756,16 @@ void TutorialGame::Pathfinding() {
 			copyPreviousPos = copyPos;
 		}*/
 	}
-	if (updatePath > 0.50f)
-		parkKeeper->GetPhysicsObject()->ClearForces();
-	else
+	// physics clears forces every update, so only push while following the current path
+	if (updatePath <= 0.50f)
 		parkKeeper->GetPhysicsObject()->AddForce(pathDirectionVec * 150.0f);
 }
 
 void TutorialGame::InitWorld() {
+	// the physics thread can't be running while objects are deleted
+	bool threadedPhysics = physics->IsThreaded();
+	physics->StopThread();
+
 	world->ClearAndErase();
 	physics->Clear();
 	
@@ -647,9 +774,71 @@ void TutorialGame::InitWorld() {
 	applesBanked = 0;
 	bonusCount = 0;
 	bonusBanked = 0;
+	collectedBonus.clear();
+	extraKeepers.clear();	// already deleted by ClearAndErase, as they were in the world
+	keeperSpawnTimer = 0.0f;
 	totalScore = 0;
 	timeLeft = 180;
 
+	// the level's only built by hand if it hasn't been saved yet - after that it's loaded,
+	// and resetting the game rebuilds it from the copy kept in memory
+	if (level.objects.empty() && !LevelFile::Load(levelName + ".level", level, LEVEL_OBJECT_KIND_COUNT)) {
+		BuildDefaultLevel();
+		LevelFile::Export(*world, levelAssets, level);
+		// the scenery goes into chunks of its own, then everything's loaded back in the normal way
+		WorldStreamer::SaveChunks(level, levelName, chunkSize);
+		LevelFile::Save(levelName + ".level", level);
+		world->ClearAndErase();
+		physics->Clear();
+	}
+	auto buildLevel = [&]() {
+		// whatever these pointed at went with ClearAndErase, and a level doesn't have to refill them all
+		std::fill(std::begin(spinner), std::end(spinner), nullptr);
+		std::fill(std::begin(dynamicCube), std::end(dynamicCube), nullptr);
+		std::fill(std::begin(trampoline), std::end(trampoline), nullptr);
+		spinnerCount = dynamicCubeCount = trampolineCount = 0;
+		goose = nullptr;
+		sentry = nullptr;
+		parkKeeper = nullptr;
+		LevelFile::Build(level, *world, levelAssets, [&](const LevelObject& o, GameObject* object) { OnLevelObject(o, object); });
+	};
+	buildLevel();
+
+	// the game can't run without these, so a level file that's lost any of them is swapped for
+	// the default level. that's kept in memory rather than saved, so the file's left as it was
+	if (!goose || !sentry || !parkKeeper) {
+		std::cout << levelName << ".level has no goose, sentry or park keeper, using the default level" << std::endl;
+		world->ClearAndErase();
+		physics->Clear();
+		BuildDefaultLevel();
+		level = LevelData();
+		LevelFile::Export(*world, levelAssets, level);
+		world->ClearAndErase();
+		physics->Clear();
+		useDefaultLevel = true;
+		buildLevel();
+	}
+
+	// a level that's never been chunked is just loaded whole, and the default level's all in memory
+	if (useDefaultLevel) {
+		streamer->Close();
+	}
+	else if (!streamer->IsOpen()) {
+		streamer->Open(levelName, streamLoadRadius, streamUnloadRadius);
+	}
+	streamer->Reset();
+	std::vector<Vector3> focus;
+	GetStreamingFocus(focus);
+	streamer->LoadNow(focus);
+
+	SentryStateMachine();
+
+	if (threadedPhysics)
+		physics->StartThread(physicsRate);
+}
+
+// where the level comes from before it's been saved, see InitWorld
+void TutorialGame::BuildDefaultLevel() {
 	/****************LEVEL FOUNDATION*****************/
 	home = AddFloorToWorld(Vector3(0, 1.2, -40), Vector3(10, 0.2, 10), "Home", CollisionType::HOME);
 	lake = AddLakeToWorld(Vector3(0, 0, -40), Vector3(40, 1, 50));
@@ -676,28 +865,28 @@ void TutorialGame::InitWorld() {
 	sentry = AddCharacterToWorld(SENTRY_SPAWN);
 
 	// gate area
-	apple[0] = AddAppleToWorld(Vector3(120, 3, -150));
+	AddAppleToWorld(Vector3(120, 3, -150));
 	// maze
-	apple[1] = AddAppleToWorld(Vector3(-88, 3, -225));
+	AddAppleToWorld(Vector3(-88, 3, -225));
 	// trampoline area
-	apple[2] = AddAppleToWorld(Vector3(150, 3, -420));
+	AddAppleToWorld(Vector3(150, 3, -420));
 	// jumping puzzle
-	apple[3] = AddAppleToWorld(Vector3(30, 9, -435));
+	AddAppleToWorld(Vector3(30, 9, -435));
 	// near sentry AI
-	apple[4] = AddAppleToWorld(Vector3(-160, 3, -450));
+	AddAppleToWorld(Vector3(-160, 3, -450));
 
 	// near home
-	bonusItem[0] = AddCubeToWorld(Vector3(35, 2, -5), Vector3(0.8, 0.8, 0.8), 10.0f, true);
+	SpawnBonusItem(Vector3(35, 2, -5));
 	// gate area
-	bonusItem[1] = AddCubeToWorld(Vector3(190, 2, -120), Vector3(0.8, 0.8, 0.8), 10.0f, true);
+	SpawnBonusItem(Vector3(190, 2, -120));
 	// maze
-	bonusItem[2] = AddCubeToWorld(Vector3(-64, 2, -329), Vector3(0.8, 0.8, 0.8), 10.0f, true);
+	SpawnBonusItem(Vector3(-64, 2, -329));
 	// jump puzzle
-	bonusItem[3] = AddCubeToWorld(Vector3(50, 14, -465), Vector3(0.8, 0.8, 0.8), 10.0f, true);
+	SpawnBonusItem(Vector3(50, 14, -465));
 	// near sentry AI
-	bonusItem[4] = AddCubeToWorld(Vector3(-175, 2, -450), Vector3(0.8, 0.8, 0.8), 10.0f, true);
+	SpawnBonusItem(Vector3(-175, 2, -450));
 	// trampoline area
-	bonusItem[5] = AddCubeToWorld(Vector3(105, 2, -455), Vector3(0.8, 0.8, 0.8), 10.0f, true);
+	SpawnBonusItem(Vector3(105, 2, -455));
 	/*************************************************/
 
 	/******************GATE AREA**********************/
@@ -745,9 +934,9 @@ void TutorialGame::InitWorld() {
 	// maze block stopper
 	AddWallToWorld(Vector3(-79, 5, -235), Vector3(1, 3, 1));
 	
-	dynamicCube[0] = AddDynamicCubeToWorld(Vector3(-71, 6, -170), Vector3(8, 4, 8), 0.001f);
-	dynamicCube[1] = AddDynamicCubeToWorld(Vector3(-191, 6, -200), Vector3(8, 4, 8), 0.001f);
-	dynamicCube[2] = AddDynamicCubeToWorld(Vector3(-71, 6, -305), Vector3(8, 4, 8), 0.001f);
+	dynamicCube[0] = AddDynamicCubeToWorld(Vector3(-71, 6, -170), Vector3(8, 4, 8), 0.0f);
+	dynamicCube[1] = AddDynamicCubeToWorld(Vector3(-191, 6, -200), Vector3(8, 4, 8), 0.0f);
+	dynamicCube[2] = AddDynamicCubeToWorld(Vector3(-71, 6, -305), Vector3(8, 4, 8), 0.0f);
 	/*************************************************/
 
 	/*******************TRAMPOLINE AREA***************/
@@ -774,7 +963,59 @@ void TutorialGame::InitWorld() {
 
 	parkKeeper = AddParkKeeperToWorld(PARK_KEEPER_SPAWN);
 
-	SentryStateMachine();
+	SetLevelKind(home, HOME);
+	SetLevelKind(lake, LAKE);
+	SetLevelKind(gate, GATE);
+	SetLevelKind(goose, GOOSE, true);
+	SetLevelKind(sentry, SENTRY, true);
+	SetLevelKind(parkKeeper, PARK_KEEPER, true);
+	for (GameObject* i : spinner)
+		SetLevelKind(i, SPINNER);
+	for (GameObject* i : dynamicCube)
+		SetLevelKind(i, DYNAMIC_CUBE);
+	for (GameObject* i : trampoline)
+		SetLevelKind(i, TRAMPOLINE);
+}
+
+// picks out the objects the game needs to get at as a level's loaded, and makes the ones it builds itself
+void TutorialGame::OnLevelObject(const LevelObject& o, GameObject* object) {
+	switch (o.kind) {
+	case HOME:
+		home = object; break;
+	case LAKE:
+		lake = object; break;
+	case GATE:
+		gate = object; break;
+	case SPINNER:
+		if (spinnerCount < 6)
+			spinner[spinnerCount++] = object;
+		break;
+	case DYNAMIC_CUBE:
+		if (dynamicCubeCount < 3)
+			dynamicCube[dynamicCubeCount++] = object;
+		break;
+	case TRAMPOLINE:
+		if (trampolineCount < 2)
+			trampoline[trampolineCount++] = object;
+		break;
+	case GOOSE:
+		goose = (GooseObject*)AddGooseToWorld(o.position);
+		SetLevelKind(goose, GOOSE, true);
+		break;
+	case SENTRY:
+		sentry = AddCharacterToWorld(o.position);
+		SetLevelKind(sentry, SENTRY, true);
+		break;
+	case PARK_KEEPER:
+		parkKeeper = AddParkKeeperToWorld(o.position);
+		SetLevelKind(parkKeeper, PARK_KEEPER, true);
+		break;
+	case BONUS_ITEM:
+		SpawnBonusItem(o.position);
+		break;
+	default:
+		break;	// extra keepers only turn up during the game
+	}
 }
 
 //From here on it's functions to add in objects to the world!
@@ -798,6 +1039,7 @@ GameObject* TutorialGame::AddFloorToWorld(const Vector3& position, Vector3 dimen
 	floor->GetPhysicsObject()->SetInverseMass(0);
 	floor->GetPhysicsObject()->InitCubeInertia();
 	floor->GetPhysicsObject()->SetCollisionType(collisionType);
+	floor->GetPhysicsObject()->SetBodyType(BodyType::STATIC);
 
 	world->AddGameObject(floor);
 
@@ -821,6 +1063,7 @@ GameObject* TutorialGame::AddOBBFloorToWorld(const Vector3& position, Vector3 di
 	floor->GetPhysicsObject()->SetInverseMass(0);
 	floor->GetPhysicsObject()->InitCubeInertia();
 	floor->GetPhysicsObject()->SetCollisionType(collisionType);
+	floor->GetPhysicsObject()->SetBodyType(BodyType::STATIC);
 
 	world->AddGameObject(floor);
 
@@ -841,6 +1084,7 @@ GameObject* TutorialGame::AddPlatformToWorld(const Vector3& position, Vector3 di
 	platform->GetPhysicsObject()->SetInverseMass(0);
 	platform->GetPhysicsObject()->InitCubeInertia();
 	platform->GetPhysicsObject()->SetCollisionType(CollisionType::FLOOR);
+	platform->GetPhysicsObject()->SetBodyType(BodyType::STATIC);
 
 	world->AddGameObject(platform);
 
@@ -861,6 +1105,7 @@ GameObject* TutorialGame::AddTrampolineToWorld(const Vector3& position, Vector3
 	trampoline->GetPhysicsObject()->SetInverseMass(0);
 	trampoline->GetPhysicsObject()->InitCubeInertia();
 	trampoline->GetPhysicsObject()->SetCollisionType(CollisionType::TRAMPOLINE);
+	trampoline->GetPhysicsObject()->SetBodyType(BodyType::STATIC);
 
 	world->AddGameObject(trampoline);
 
@@ -881,6 +1126,7 @@ GameObject* TutorialGame::AddLakeToWorld(const Vector3& position, Vector3 dimens
 	lake->GetPhysicsObject()->SetInverseMass(0);
 	lake->GetPhysicsObject()->InitCubeInertia();
 	lake->GetPhysicsObject()->SetCollisionType(CollisionType::LAKE);
+	lake->GetPhysicsObject()->SetBodyType(BodyType::STATIC);
 
 	world->AddGameObject(lake);
 
@@ -901,6 +1147,7 @@ GameObject* TutorialGame::AddWallToWorld(const Vector3& position, Vector3 dimens
 	wall->GetPhysicsObject()->SetInverseMass(0);
 	wall->GetPhysicsObject()->InitCubeInertia();
 	wall->GetPhysicsObject()->SetCollisionType(CollisionType::WALL);
+	wall->GetPhysicsObject()->SetBodyType(BodyType::STATIC);
 
 	world->AddGameObject(wall);
 
@@ -980,6 +1227,12 @@ GameObject* TutorialGame::AddSphereToWorld(const Vector3& position, float radius
 }
 
 GameObject* TutorialGame::AddCubeToWorld(const Vector3& position, Vector3 dimensions, float inverseMass, bool collectable) {
+	GameObject* cube = CreateCube(position, dimensions, inverseMass, collectable);
+	world->AddGameObject(cube);
+	return cube;
+}
+
+GameObject* TutorialGame::CreateCube(const Vector3& position, Vector3 dimensions, float inverseMass, bool collectable) {
 	string name = "Cube";
 	if (collectable)
 		name = "CollectableCube";
@@ -1007,8 +1260,6 @@ GameObject* TutorialGame::AddCubeToWorld(const Vector3& position, Vector3 dimens
 	cube->GetPhysicsObject()->SetElasticity(0.0);
 	cube->GetPhysicsObject()->InitCubeInertia();
 
-	world->AddGameObject(cube);
-
 	return cube;
 }
 
@@ -1030,6 +1281,7 @@ GameObject* TutorialGame::AddDynamicCubeToWorld(const Vector3& position, Vector3
 	cube->GetPhysicsObject()->SetInverseMass(inverseMass);
 	cube->GetPhysicsObject()->InitCubeInertia();
 	cube->GetPhysicsObject()->SetCollisionType(CollisionType::IMMOVABLE);
+	cube->GetPhysicsObject()->SetBodyType(BodyType::KINEMATIC);
 
 	world->AddGameObject(cube);
 
@@ -1065,6 +1317,13 @@ GameObject* TutorialGame::AddGooseToWorld(const Vector3& position) {
 }
 
 GameObject* TutorialGame::AddParkKeeperToWorld(const Vector3& position)
+{
+	GameObject* keeper = CreateParkKeeper(position);
+	world->AddGameObject(keeper);
+	return keeper;
+}
+
+GameObject* TutorialGame::CreateParkKeeper(const Vector3& position)
 {
 	float meshSize = 4.0f;
 	float inverseMass = 0.5f;
@@ -1085,8 +1344,6 @@ GameObject* TutorialGame::AddParkKeeperToWorld(const Vector3& position)
 	keeper->GetPhysicsObject()->InitCubeInertia();
 	keeper->GetPhysicsObject()->SetCollisionType(CollisionType::AI);
 
-	world->AddGameObject(keeper);
-
 	return keeper;
 }
 
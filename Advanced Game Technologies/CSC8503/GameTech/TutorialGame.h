@@ -6,6 +6,8 @@
 #include "../CSC8503Common/State.h"
 #include "../CSC8503Common//GooseObject.h"
 #include "../CSC8503Common/NavigationGrid.h"
+#include "../CSC8503Common/LevelFile.h"
+#include "../CSC8503Common/WorldStreamer.h"
 #include <sstream>
 #include <iomanip>
 
@@ -25,6 +27,27 @@ namespace NCL {
 			void UpdateKeys();
 
 			void InitWorld();
+			void BuildDefaultLevel();
+			void OnLevelObject(const LevelObject& o, GameObject* object);
+
+			// what each object in the level is to the game, saved with the level - only add to the end!
+			enum LevelObjectKind {
+				SCENERY,
+				HOME,
+				LAKE,
+				GATE,
+				SPINNER,
+				DYNAMIC_CUBE,
+				TRAMPOLINE,
+				GOOSE,
+				SENTRY,
+				PARK_KEEPER,
+				BONUS_ITEM,
+				EXTRA_KEEPER,
+				LEVEL_OBJECT_KIND_COUNT
+			};
+			void SetLevelKind(GameObject* o, LevelObjectKind kind, bool spawnPoint = false);
+			void GetStreamingFocus(std::vector<Vector3>& points) const;
 
 			/*
 			These are some of the world/object creation functions I created when testing the functionality
@@ -45,7 +68,12 @@ namespace NCL {
 			void PlayerMovement();
 			void InitMisc();
 			void ResetGame();
-			void UpdateMovingBlocks();
+			void UpdateMovingBlocks(float dt);
+			void UpdateExtraKeepers(float dt);
+			void InitPrototypes();
+			GameObjectHandle SpawnBonusItem(const Vector3& position);
+			void OnCollected(GameObject* o);
+			void DisplayPoolStats();
 			void SentryStateMachine();
 			void Pathfinding();
 			//void ParkKeeperStateMachine();
@@ -57,10 +85,12 @@ namespace NCL {
 			GameObject* AddWallToWorld(const Vector3& position, Vector3 dimensions = Vector3(100, 2, 100), string name = "Wall");
 			GameObject* AddSphereToWorld(const Vector3& position, float radius, float inverseMass = 10.0f, bool hollow = false);
 			GameObject* AddCubeToWorld(const Vector3& position, Vector3 dimensions, float inverseMass = 10.0f, bool collectable = false);
+			GameObject* CreateCube(const Vector3& position, Vector3 dimensions, float inverseMass = 10.0f, bool collectable = false);
 			GameObject* AddDynamicCubeToWorld(const Vector3& position, Vector3 dimensions, float inverseMass = 10.0f);
 			//IT'S HAPPENING
 			GameObject* AddGooseToWorld(const Vector3& position);
 			GameObject* AddParkKeeperToWorld(const Vector3& position);
+			GameObject* CreateParkKeeper(const Vector3& position);
 			GameObject* AddCharacterToWorld(const Vector3& position);
 			GameObject* AddAppleToWorld(const Vector3& position);
 			GameObject* AddLakeToWorld(const Vector3& position, Vector3 dimensions, string name = "Lake");
@@ -70,6 +100,18 @@ namespace NCL {
 			GameObject* AddSpinnerToWorld(const Vector3& position, Vector3 dimensions, string name = "Spinner");
 
 
+			// loaded once, then rebuilt from memory whenever the game's reset
+			LevelData			level;
+			LevelAssets			levelAssets;
+			const string		levelName = "Goose";
+			bool				useDefaultLevel = false;	// the saved level couldn't be played, see InitWorld
+
+			// the level's scenery is streamed in around the goose and the AI
+			WorldStreamer*		streamer;
+			const float			chunkSize			= 100.0f;
+			const float			streamLoadRadius	= 150.0f;
+			const float			streamUnloadRadius	= 200.0f;
+
 			GameTechRenderer*	renderer;
 			PhysicsSystem*		physics;
 			GameWorld*			world;
@@ -79,6 +121,8 @@ namespace NCL {
 			bool inSelectionMode;
 			bool enablePathfinding;
 
+			float physicsRate = 120.0f;	// updates per second when physics is threaded
+
 			float		forceMagnitude;
 
 			GameObject* selectionObject = nullptr;
@@ -109,10 +153,11 @@ namespace NCL {
 			GameObject* gate = nullptr; 
 			GameObject* parkKeeper = nullptr;
 			GameObject* spinner[6];
-			GameObject* apple[5];
-			GameObject* bonusItem[6];
 			GameObject* dynamicCube[3];
 			GameObject* trampoline[2];
+			int spinnerCount		= 0;	// how many of the above have been filled in by a level load
+			int dynamicCubeCount	= 0;
+			int trampolineCount		= 0;
 
 			const Vector3 GOOSE_SPAWN = Vector3(0, 3, -40);
 			const Vector3 SENTRY_SPAWN = Vector3(-180, 3, -470);
@@ -130,12 +175,22 @@ namespace NCL {
 
 			Vector4 originalColour = Vector4(1, 1, 1, 1);
 
-			std::vector<GameObject*> collectedApples;
-			std::vector<GameObject*> collectedBonus;
+			// where to put each carried bonus item back if it's dropped
+			std::vector<Vector3> collectedBonus;
+
+			// pooled by the world, see InitPrototypes
+			int bonusPrototype	= -1;
+			int keeperPrototype	= -1;
+
+			std::vector<GameObjectHandle> extraKeepers;
+			float keeperSpawnTimer = 0.0f;
+			const float keeperSpawnTime = 30.0f;
+			const size_t maxExtraKeepers = 4;
 
 			int timeLeft = 180;
 			float timePassed = 0;
 			float cubeDirection[3] = { 1.0f, 1.0f, 1.0f };
+			float movingBlockSpeed = 30.0f;
 
 			StateMachine* stateMachine;
 
@@ -143,6 +198,7 @@ namespace NCL {
 
 			bool canJump = true;
 			bool displayObjectInfo = false;
+			bool displayPoolStats = false;
 
 			vector<Vector3> pathNodes;
 
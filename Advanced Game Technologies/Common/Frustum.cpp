@@ -0,0 +1,61 @@
+/*
+Part of Newcastle University's Game Engineering source code.
+
+Use as you see fit!
+
+Comments and queries to: richard-gordon.davison AT ncl.ac.uk
+https://research.ncl.ac.uk/game/
+*/
+#include "Frustum.h"
+#include "Camera.h"
+#include "Vector4.h"
+#include <cmath>
+
+using namespace NCL;
+using namespace NCL::Maths;
+
+void Frustum::FromMatrix(const Matrix4 &viewProj) {
+	Vector4 xRow = viewProj.GetRow(0);
+	Vector4 yRow = viewProj.GetRow(1);
+	Vector4 zRow = viewProj.GetRow(2);
+	Vector4 wRow = viewProj.GetRow(3);
+
+	Vector3 xAxis = Vector3(xRow.x, xRow.y, xRow.z);
+	Vector3 yAxis = Vector3(yRow.x, yRow.y, yRow.z);
+	Vector3 zAxis = Vector3(zRow.x, zRow.y, zRow.z);
+	Vector3 wAxis = Vector3(wRow.x, wRow.y, wRow.z);
+
+	planes[0] = Plane(wAxis + xAxis, wRow.w + xRow.w, true);	//LEFT
+	planes[1] = Plane(wAxis - xAxis, wRow.w - xRow.w, true);	//RIGHT
+	planes[2] = Plane(wAxis + yAxis, wRow.w + yRow.w, true);	//BOTTOM
+	planes[3] = Plane(wAxis - yAxis, wRow.w - yRow.w, true);	//TOP
+	planes[4] = Plane(wAxis + zAxis, wRow.w + zRow.w, true);	//NEAR
+	planes[5] = Plane(wAxis - zAxis, wRow.w - zRow.w, true);	//FAR
+}
+
+Frustum Frustum::FromCamera(const Camera &c, float aspect) {
+	Frustum f;
+	f.FromMatrix(c.BuildProjectionMatrix(aspect) * c.BuildViewMatrix());
+	return f;
+}
+
+bool Frustum::SphereInsideFrustum(const Vector3 &position, float radius) const {
+	for (int i = 0; i < 6; ++i) {
+		if (!planes[i].SphereInPlane(position, radius)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Frustum::AABBInsideFrustum(const Vector3 &position, const Vector3 &halfSize) const {
+	for (int i = 0; i < 6; ++i) {
+		Vector3 normal = planes[i].GetNormal();
+		//How far the box reaches towards the plane's normal
+		float extent = std::abs(normal.x) * halfSize.x + std::abs(normal.y) * halfSize.y + std::abs(normal.z) * halfSize.z;
+		if (planes[i].DistanceFromPlane(position) + extent < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,37 @@
+/*
+Part of Newcastle University's Game Engineering source code.
+
+Use as you see fit!
+
+Comments and queries to: richard-gordon.davison AT ncl.ac.uk
+https://research.ncl.ac.uk/game/
+*/
+#pragma once
+#include "Plane.h"
+#include "Matrix4.h"
+
+namespace NCL {
+	class Camera;
+	namespace Maths {
+		class Frustum {
+		public:
+			Frustum(void) {};
+			~Frustum(void) {};
+
+			//Builds the 6 planes from a combined projection * view matrix
+			void FromMatrix(const Matrix4 &viewProj);
+
+			static Frustum FromCamera(const Camera &c, float aspect);
+
+			//Is the sphere / box at least partly inside all of the planes?
+			bool SphereInsideFrustum(const Vector3 &position, float radius) const;
+			bool AABBInsideFrustum(const Vector3 &position, const Vector3 &halfSize) const;
+
+			const Plane& GetPlane(int i) const { return planes[i]; }
+
+		protected:
+			//left, right, bottom, top, near, far - all facing inwards
+			Plane planes[6];
+		};
+	}
+}
@@ -0,0 +1,159 @@
+/*
+Part of Newcastle University's Game Engineering source code.
+
+Use as you see fit!
+
+Comments and queries to: richard-gordon.davison AT ncl.ac.uk
+https://research.ncl.ac.uk/game/
+*/
+#pragma once
+/*
+Optional SIMD backend for the maths classes. Define NCL_MATHS_SIMD in every project's
+preprocessor settings to turn it on - it changes the alignment of Vector4 and Matrix4,
+so every project linking against Common has to agree on it. 64 bit x86 builds use SSE,
+64 bit ARM builds use NEON, and anything else carries on with the plain scalar code.
+
+By default everything is 'strict' - every SIMD path does the same operations in the same
+order as the scalar code (no fused multiply adds, no reordered sums), so results are bit
+for bit the same whichever backend is in use, and replays / networking stay deterministic.
+Also defining NCL_MATHS_FAST lets Normalise use an approximate reciprocal square root
+instead, which is quicker but no longer matches the scalar results exactly.
+*/
+#if defined(NCL_MATHS_SIMD) && (defined(_M_X64) || defined(__x86_64__))
+#define NCL_SIMD_SSE
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#elif defined(NCL_MATHS_SIMD) && (defined(_M_ARM64) || defined(__aarch64__))
+#define NCL_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(NCL_SIMD_SSE) || defined(NCL_SIMD_NEON)
+#define NCL_SIMD_ENABLED
+#define NCL_MATHS_ALIGN alignas(16)
+#else
+#define NCL_MATHS_ALIGN
+#endif
+
+#ifdef NCL_SIMD_ENABLED
+#include <cmath>
+
+namespace NCL {
+	namespace Maths {
+		namespace SIMD {
+#ifdef NCL_SIMD_SSE
+			typedef __m128 Float4;
+
+			// nothing is assumed to be aligned - heap allocations aren't always
+			inline Float4 Load(const float* f)			{ return _mm_loadu_ps(f); }
+			inline void   Store(float* f, Float4 v)		{ _mm_storeu_ps(f, v); }
+			inline Float4 Set(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+			inline Float4 Splat(float f)				{ return _mm_set1_ps(f); }
+			inline Float4 Zero()						{ return _mm_setzero_ps(); }
+
+			inline Float4 Add(Float4 a, Float4 b)		{ return _mm_add_ps(a, b); }
+			inline Float4 Sub(Float4 a, Float4 b)		{ return _mm_sub_ps(a, b); }
+			inline Float4 Mul(Float4 a, Float4 b)		{ return _mm_mul_ps(a, b); }
+			inline Float4 Div(Float4 a, Float4 b)		{ return _mm_div_ps(a, b); }
+			inline Float4 Xor(Float4 a, Float4 b)		{ return _mm_xor_ps(a, b); }
+
+			template<int X, int Y, int Z, int W>
+			inline Float4 Swizzle(Float4 v)				{ return _mm_shuffle_ps(v, v, _MM_SHUFFLE(W, Z, Y, X)); }
+
+			template<int I>
+			inline float Lane(Float4 v)					{ return _mm_cvtss_f32(Swizzle<I, I, I, I>(v)); }
+
+			inline Float4 ReciprocalSqrtEstimate(Float4 v) { return _mm_rsqrt_ps(v); }
+#else
+			typedef float32x4_t Float4;
+
+			inline Float4 Load(const float* f)			{ return vld1q_f32(f); }
+			inline void   Store(float* f, Float4 v)		{ vst1q_f32(f, v); }
+			inline Float4 Set(float x, float y, float z, float w) {
+				const float f[4] = { x, y, z, w };
+				return vld1q_f32(f);
+			}
+			inline Float4 Splat(float f)				{ return vdupq_n_f32(f); }
+			inline Float4 Zero()						{ return vdupq_n_f32(0.0f); }
+
+			inline Float4 Add(Float4 a, Float4 b)		{ return vaddq_f32(a, b); }
+			inline Float4 Sub(Float4 a, Float4 b)		{ return vsubq_f32(a, b); }
+			inline Float4 Mul(Float4 a, Float4 b)		{ return vmulq_f32(a, b); }
+			inline Float4 Div(Float4 a, Float4 b)		{ return vdivq_f32(a, b); }
+			inline Float4 Xor(Float4 a, Float4 b)		{ return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+
+			// a byte table lookup, picking out the 4 bytes of each lane we want
+			template<int X, int Y, int Z, int W>
+			inline Float4 Swizzle(Float4 v) {
+				const uint8_t table[16] = {
+					X * 4, X * 4 + 1, X * 4 + 2, X * 4 + 3,
+					Y * 4, Y * 4 + 1, Y * 4 + 2, Y * 4 + 3,
+					Z * 4, Z * 4 + 1, Z * 4 + 2, Z * 4 + 3,
+					W * 4, W * 4 + 1, W * 4 + 2, W * 4 + 3
+				};
+				return vreinterpretq_f32_u8(vqtbl1q_u8(vreinterpretq_u8_f32(v), vld1q_u8(table)));
+			}
+
+			template<int I>
+			inline float Lane(Float4 v)					{ return vgetq_lane_f32(v, I); }
+
+			inline Float4 ReciprocalSqrtEstimate(Float4 v) { return vrsqrteq_f32(v); }
+#endif
+			inline Float4 Load3(const float* f, float w = 0.0f) {
+				return Set(f[0], f[1], f[2], w);
+			}
+
+			inline void Store3(float* f, Float4 v) {
+				float temp[4];
+				Store(temp, v);
+				f[0] = temp[0];
+				f[1] = temp[1];
+				f[2] = temp[2];
+			}
+
+			template<int I>
+			inline Float4 SplatLane(Float4 v) {
+				return Swizzle<I, I, I, I>(v);
+			}
+
+			// flips the sign of each lane whose template argument is negative
+			template<int X, int Y, int Z, int W>
+			inline Float4 Signs(Float4 v) {
+				return Xor(v, Set(X < 0 ? -0.0f : 0.0f, Y < 0 ? -0.0f : 0.0f, Z < 0 ? -0.0f : 0.0f, W < 0 ? -0.0f : 0.0f));
+			}
+
+			// summed x, y, z then w, the same order the scalar code adds them in
+			inline float Sum4(Float4 v) {
+				return ((Lane<0>(v) + Lane<1>(v)) + Lane<2>(v)) + Lane<3>(v);
+			}
+
+			inline float Sum3(Float4 v) {
+				return (Lane<0>(v) + Lane<1>(v)) + Lane<2>(v);
+			}
+
+			/*
+			Scales v by 1 / sqrt(lengthSq), leaving it alone if lengthSq is 0. In strict mode
+			that's exactly what the scalar Normalise functions do - with NCL_MATHS_FAST it uses
+			the hardware estimate, refined with a single Newton-Raphson step.
+			*/
+			inline Float4 ScaleByInverseLength(Float4 v, float lengthSq) {
+#ifdef NCL_MATHS_FAST
+				if (lengthSq <= 0.0f) {
+					return v;
+				}
+				Float4 l	= Splat(lengthSq);
+				Float4 e	= ReciprocalSqrtEstimate(l);
+				e			= Mul(Mul(Splat(0.5f), e), Sub(Splat(3.0f), Mul(Mul(l, e), e)));
+				return Mul(v, e);
+#else
+				float length = sqrt(lengthSq);
+				if (length == 0.0f) {
+					return v;
+				}
+				return Mul(v, Splat(1.0f / length));
+#endif
+			}
+		}
+	}
+}
+#endif
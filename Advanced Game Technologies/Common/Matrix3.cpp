@@ -299,10 +299,18 @@ void	Matrix3::SetDiagonal(const Vector3 &in) {
 
 Vector3 Matrix3::operator*(const Vector3 &v) const {
 	Vector3 vec;
+#ifdef NCL_SIMD_ENABLED
+	SIMD::Float4 result = SIMD::Mul(SIMD::Load3(array), SIMD::Splat(v.x));
+	result = SIMD::Add(result, SIMD::Mul(SIMD::Load3(array + 3), SIMD::Splat(v.y)));
+	result = SIMD::Add(result, SIMD::Mul(SIMD::Load3(array + 6), SIMD::Splat(v.z)));
+	SIMD::Store3(&vec.x, result);
+	return vec;
+#else
 
 	vec.x = v.x*array[0] + v.y*array[3] + v.z*array[6];
 	vec.y = v.x*array[1] + v.y*array[4] + v.z*array[7];
 	vec.z = v.x*array[2] + v.y*array[5] + v.z*array[8];
 
 	return vec;
+#endif
 };
\ No newline at end of file
@@ -10,6 +10,7 @@ https://research.ncl.ac.uk/game/
 #include <assert.h>
 #include <algorithm>
 #include <iostream>
+#include "MathsSIMD.h"
 
 namespace NCL {
 	namespace Maths {
@@ -79,6 +80,18 @@ namespace NCL {
 
 			inline Matrix3 operator*(const Matrix3 &a) const {
 				Matrix3 out;
+#ifdef NCL_SIMD_ENABLED
+				//Columns are only 3 floats, so they're loaded and stored a lane short
+				SIMD::Float4 cols[3] = { SIMD::Load3(array), SIMD::Load3(array + 3), SIMD::Load3(array + 6) };
+				for (unsigned int r = 0; r < 3; ++r) {
+					SIMD::Float4 total = SIMD::Zero();
+					for (unsigned int i = 0; i < 3; ++i) {
+						total = SIMD::Add(total, SIMD::Mul(cols[i], SIMD::Splat(a.array[(r * 3) + i])));
+					}
+					SIMD::Store3(out.array + (r * 3), total);
+				}
+				return out;
+#else
 				//Students! You should be able to think up a really easy way of speeding this up...
 				for (unsigned int r = 0; r < 3; ++r) {
 					for (unsigned int c = 0; c < 3; ++c) {
@@ -89,6 +102,7 @@ namespace NCL {
 					}
 				}
 				return out;
+#endif
 			}
 
 			//Creates a rotation matrix that rotates by 'degrees' around the 'axis'
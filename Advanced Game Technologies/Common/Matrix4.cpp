@@ -201,6 +201,35 @@ Matrix4 Matrix4::Translation( const Vector3 &translation )	{
 	return m;
 }
 
+Matrix4 Matrix4::FromTRS(const Vector3& position, const Quaternion& orientation, const Vector3& scale) {
+	Matrix4 m(orientation);
+
+	for (int i = 0; i < 3; ++i) {
+		m.array[i]		*= scale.x;
+		m.array[i + 4]	*= scale.y;
+		m.array[i + 8]	*= scale.z;
+	}
+	m.array[12] = position.x;
+	m.array[13] = position.y;
+	m.array[14] = position.z;
+
+	return m;
+}
+
+Matrix4 Matrix4::AffineMultiply(const Matrix4& a, const Matrix4& b) {
+	Matrix4 out;
+	for (unsigned int r = 0; r < 4; ++r) {
+		for (unsigned int c = 0; c < 3; ++c) {
+			float total = 0.0f;
+			for (unsigned int i = 0; i < 3; ++i) {
+				total += a.array[c + (i * 4)] * b.array[(r * 4) + i];
+			}
+			out.array[c + (r * 4)] = r == 3 ? total + a.array[c + 12] : total;
+		}
+	}
+	return out;
+}
+
 //Yoinked from the Open Source Doom 3 release - all credit goes to id software!
 void    Matrix4::Invert() {
 	float det, invDet;
@@ -281,6 +310,22 @@ Matrix4 Matrix4::Inverse()	const {
 	return temp;
 }
 
+Matrix4 Matrix4::InverseRigid() const {
+	const float* m = array;
+	Matrix4 out;
+
+	for (int c = 0; c < 3; ++c) {
+		for (int r = 0; r < 3; ++r) {
+			out.array[(c * 4) + r] = m[(r * 4) + c];
+		}
+	}
+	out.array[12] = -(out.array[0] * m[12] + out.array[4] * m[13] + out.array[8]  * m[14]);
+	out.array[13] = -(out.array[1] * m[12] + out.array[5] * m[13] + out.array[9]  * m[14]);
+	out.array[14] = -(out.array[2] * m[12] + out.array[6] * m[13] + out.array[10] * m[14]);
+
+	return out;
+}
+
 Vector4 Matrix4::GetRow(unsigned int row) const {
 	Vector4 out(0, 0, 0, 1);
 	if (row <= 3) {
@@ -306,6 +351,15 @@ Vector4 Matrix4::GetColumn(unsigned int column) const {
 
 Vector3 Matrix4::operator*(const Vector3 &v) const {
 	Vector3 vec;
+#ifdef NCL_SIMD_ENABLED
+	SIMD::Float4 result = SIMD::Mul(SIMD::Load(array), SIMD::Splat(v.x));
+	result = SIMD::Add(result, SIMD::Mul(SIMD::Load(array + 4), SIMD::Splat(v.y)));
+	result = SIMD::Add(result, SIMD::Mul(SIMD::Load(array + 8), SIMD::Splat(v.z)));
+	result = SIMD::Add(result, SIMD::Load(array + 12));
+	result = SIMD::Div(result, SIMD::SplatLane<3>(result));
+	SIMD::Store3(&vec.x, result);
+	return vec;
+#else
 
 	float temp;
 
@@ -320,13 +374,24 @@ Vector3 Matrix4::operator*(const Vector3 &v) const {
 	vec.z = vec.z / temp;
 
 	return vec;
+#endif
 }
 
 Vector4 Matrix4::operator*(const Vector4 &v) const {
+#ifdef NCL_SIMD_ENABLED
+	Vector4 vec;
+	SIMD::Float4 result = SIMD::Mul(SIMD::Load(array), SIMD::Splat(v.x));
+	result = SIMD::Add(result, SIMD::Mul(SIMD::Load(array + 4), SIMD::Splat(v.y)));
+	result = SIMD::Add(result, SIMD::Mul(SIMD::Load(array + 8), SIMD::Splat(v.z)));
+	result = SIMD::Add(result, SIMD::Mul(SIMD::Load(array + 12), SIMD::Splat(v.w)));
+	SIMD::Store(vec.array, result);
+	return vec;
+#else
 	return Vector4(
 		v.x*array[0] + v.y*array[4] + v.z*array[8] + v.w * array[12],
 		v.x*array[1] + v.y*array[5] + v.z*array[9] + v.w * array[13],
 		v.x*array[2] + v.y*array[6] + v.z*array[10] + v.w * array[14],
 		v.x*array[3] + v.y*array[7] + v.z*array[11] + v.w * array[15]
 	);
+#endif
 }
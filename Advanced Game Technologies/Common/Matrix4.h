@@ -9,6 +9,7 @@ https://research.ncl.ac.uk/game/
 #pragma once
 
 #include <iostream>
+#include "MathsSIMD.h"
 
 namespace NCL {
 	namespace Maths {
@@ -17,7 +18,7 @@ namespace NCL {
 		class Matrix3;
 		class Quaternion;
 
-		class Matrix4 {
+		class NCL_MATHS_ALIGN Matrix4 {
 		public:
 			Matrix4(void);
 			Matrix4(float elements[16]);
@@ -52,6 +53,14 @@ namespace NCL {
 			//floats 12, 13, and 14. Analogous to glTranslatef
 			static Matrix4 Translation(const Vector3& translation);
 
+			//Creates Translation(position) * Matrix4(orientation) * Scale(scale), but
+			//fills the matrix in directly rather than doing two full multiplies
+			static Matrix4 FromTRS(const Vector3& position, const Quaternion& orientation, const Vector3& scale);
+
+			//Same as a * b, for matrices with a bottom row of (0,0,0,1) - ie anything
+			//made out of translations, rotations and scales. Skips the bottom row.
+			static Matrix4 AffineMultiply(const Matrix4& a, const Matrix4& b);
+
 			//Creates a perspective matrix, with 'znear' and 'zfar' as the near and 
 			//far planes, using 'aspect' and 'fov' as the aspect ratio and vertical
 			//field of vision, respectively.
@@ -69,6 +78,10 @@ namespace NCL {
 			void    Invert();
 			Matrix4 Inverse() const;
 
+			//Inverse of a matrix built out of only translations and rotations - no scale! The
+			//rotation part just gets transposed, and the translation rotated back and negated
+			Matrix4 InverseRigid() const;
+
 
 			Vector4 GetRow(unsigned int row) const;
 			Vector4 GetColumn(unsigned int column) const;
@@ -76,6 +89,18 @@ namespace NCL {
 			//Multiplies 'this' matrix by matrix 'a'. Performs the multiplication in 'OpenGL' order (ie, backwards)
 			inline Matrix4 operator*(const Matrix4& a) const {
 				Matrix4 out;
+#ifdef NCL_SIMD_ENABLED
+				//Each output column is a weighted sum of our columns. Starts from zero, as the scalar version does
+				SIMD::Float4 cols[4] = { SIMD::Load(array), SIMD::Load(array + 4), SIMD::Load(array + 8), SIMD::Load(array + 12) };
+				for (unsigned int r = 0; r < 4; ++r) {
+					SIMD::Float4 total = SIMD::Zero();
+					for (unsigned int i = 0; i < 4; ++i) {
+						total = SIMD::Add(total, SIMD::Mul(cols[i], SIMD::Splat(a.array[(r * 4) + i])));
+					}
+					SIMD::Store(out.array + (r * 4), total);
+				}
+				return out;
+#else
 				//Students! You should be able to think up a really easy way of speeding this up...
 				for (unsigned int r = 0; r < 4; ++r) {
 					for (unsigned int c = 0; c < 4; ++c) {
@@ -86,6 +111,7 @@ namespace NCL {
 					}
 				}
 				return out;
+#endif
 			}
 
 			Vector3 operator*(const Vector3& v) const;
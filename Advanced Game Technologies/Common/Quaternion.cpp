@@ -80,6 +80,13 @@ float Quaternion::Dot(const Quaternion &a,const Quaternion &b){
 }
 
 void Quaternion::Normalise(){
+#ifdef NCL_SIMD_ENABLED
+	SIMD::Float4 q = SIMD::Load(array);
+	float magnitudeSq = SIMD::Sum4(SIMD::Mul(q, q));
+	if (magnitudeSq > 0.0f) {
+		SIMD::Store(array, SIMD::ScaleByInverseLength(q, magnitudeSq));
+	}
+#else
 	float magnitude = sqrt(x*x + y*y + z*z + w*w);
 
 	if(magnitude > 0.0f){
@@ -90,6 +97,7 @@ void Quaternion::Normalise(){
 		z *= t;
 		w *= t;
 	}
+#endif
 }
 
 void Quaternion::CalculateW()	{
@@ -116,7 +124,13 @@ Quaternion Quaternion::Lerp(const Quaternion &from, const Quaternion &to, float
 		temp = -to;
 	}
 
+#ifdef NCL_SIMD_ENABLED
+	Quaternion out;
+	SIMD::Store(out.array, SIMD::Add(SIMD::Mul(SIMD::Load(from.array), SIMD::Splat(1.0f - by)), SIMD::Mul(SIMD::Load(temp.array), SIMD::Splat(by))));
+	return out;
+#else
 	return (from * (1.0f - by)) + (temp * by);
+#endif
 }
 
 Quaternion Quaternion::Slerp(const Quaternion &from, const Quaternion &to, float by) {
@@ -128,7 +142,14 @@ Quaternion Quaternion::Slerp(const Quaternion &from, const Quaternion &to, float
 		temp = -to;
 	}
 
+#ifdef NCL_SIMD_ENABLED
+	//The weights are worked out exactly as the scalar version does, so they round the same
+	Quaternion out;
+	SIMD::Store(out.array, SIMD::Add(SIMD::Mul(SIMD::Load(from.array), SIMD::Splat((float)cos(by))), SIMD::Mul(SIMD::Load(to.array), SIMD::Splat((float)(1.0f - cos(by))))));
+	return out;
+#else
 	return (from * (cos(by))) + (to * (1.0f - cos(by)));
+#endif
 }
 
 //http://en.wikipedia.org/wiki/Conversion_between_quaternions_and_Euler_angles
@@ -8,6 +8,7 @@ https://research.ncl.ac.uk/game/
 */
 #pragma once
 #include <iostream>
+#include "MathsSIMD.h"
 
 namespace NCL {
 	namespace Maths {
@@ -67,12 +68,25 @@ namespace NCL {
 			}
 
 			inline Quaternion  operator *(const Quaternion &b)	const {
+#ifdef NCL_SIMD_ENABLED
+				//Each lane is summed in the same order as the scalar version below, with subtractions as negated adds
+				SIMD::Float4 qa = SIMD::Load(array);
+				SIMD::Float4 qb = SIMD::Load(b.array);
+				SIMD::Float4 result = SIMD::Mul(qa, SIMD::SplatLane<3>(qb));
+				result = SIMD::Add(result, SIMD::Signs<1, 1, 1, -1>(SIMD::Mul(SIMD::Swizzle<3, 3, 3, 0>(qa), SIMD::Swizzle<0, 1, 2, 0>(qb))));
+				result = SIMD::Add(result, SIMD::Signs<1, 1, 1, -1>(SIMD::Mul(SIMD::Swizzle<1, 2, 0, 1>(qa), SIMD::Swizzle<2, 0, 1, 1>(qb))));
+				result = SIMD::Add(result, SIMD::Signs<-1, -1, -1, -1>(SIMD::Mul(SIMD::Swizzle<2, 0, 1, 2>(qa), SIMD::Swizzle<1, 2, 0, 2>(qb))));
+				Quaternion out;
+				SIMD::Store(out.array, result);
+				return out;
+#else
 				return Quaternion(
 					(x * b.w) + (w * b.x) + (y * b.z) - (z * b.y),
 					(y * b.w) + (w * b.y) + (z * b.x) - (x * b.z),
 					(z * b.w) + (w * b.z) + (x * b.y) - (y * b.x),
 					(w * b.w) - (x * b.x) - (y * b.y) - (z * b.z)
 				);
+#endif
 			}
 
 			Vector3		operator *(const Vector3 &a)	const;
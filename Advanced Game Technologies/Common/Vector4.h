@@ -8,13 +8,14 @@ https://research.ncl.ac.uk/game/
 */
 #pragma once
 #include <iostream>
+#include "MathsSIMD.h"
 
 namespace NCL {
 	namespace Maths {
 		class Vector3;
 		class Vector2;
 
-		class Vector4 {
+		class NCL_MATHS_ALIGN Vector4 {
 
 		public:
 			union {
@@ -44,6 +45,10 @@ namespace NCL {
 			}
 
 			void			Normalise() {
+#ifdef NCL_SIMD_ENABLED
+				SIMD::Float4 v = SIMD::Load(array);
+				SIMD::Store(array, SIMD::ScaleByInverseLength(v, SIMD::Sum3(SIMD::Mul(v, v))));
+#else
 				float length = Length();
 
 				if (length != 0.0f) {
@@ -53,6 +58,7 @@ namespace NCL {
 					z = z * length;
 					w = w * length;
 				}
+#endif
 			}
 
 			float	Length() const {
@@ -0,0 +1,381 @@
+/*
+Throughput benchmarks for the hot parts of the Common maths library.
+
+Each benchmark runs an operation over a large array of random inputs a number of times,
+keeps the fastest run, and reports it in nanoseconds per operation. The maths sources
+are compiled straight into this program rather than linked from Common, so the x64
+builds can turn NCL_MATHS_SIMD on here without affecting the rest of the solution.
+Operations with a SIMD path are also run through a plain scalar copy of the original
+code, so both backends can be compared from a single run.
+
+Build it in Release - Debug numbers don't mean anything.
+
+It also checks that the library's results are bit for bit the same as the scalar copy's
+(see MathsSIMD.h), and how much accuracy the networking code's quaternion compression
+gives up for its size, as that's maths the game relies on that isn't in Common. The
+program returns non-zero if either check fails, so it can be run as a test.
+*/
+#include "../Common/Matrix4.h"
+#include "../Common/Matrix3.h"
+#include "../Common/Quaternion.h"
+#include "../Common/Vector3.h"
+#include "../Common/Vector4.h"
+#include "../Common/Maths.h"
+#include "../CSC8503/CSC8503Common/QuaternionCompression.h"
+
+#include <chrono>
+#include <vector>
+#include <string>
+#include <functional>
+#include <random>
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+
+using namespace NCL;
+using namespace NCL::Maths;
+
+const size_t	arraySize	= 4096;		// small enough to stay in cache, so we measure the maths and not memory
+const int		repeats		= 200;
+const int		runs		= 5;
+
+// stops the compiler throwing away results it can see are never used
+volatile float benchmarkSink = 0.0f;
+
+/*
+The scalar code from before the SIMD backend, so there's always something to compare against
+*/
+namespace Reference {
+	Matrix4 Multiply(const Matrix4& a, const Matrix4& b) {
+		Matrix4 out;
+		for (unsigned int r = 0; r < 4; ++r) {
+			for (unsigned int c = 0; c < 4; ++c) {
+				out.array[c + (r * 4)] = 0.0f;
+				for (unsigned int i = 0; i < 4; ++i) {
+					out.array[c + (r * 4)] += a.array[c + (i * 4)] * b.array[(r * 4) + i];
+				}
+			}
+		}
+		return out;
+	}
+
+	Matrix3 Multiply(const Matrix3& a, const Matrix3& b) {
+		Matrix3 out;
+		for (unsigned int r = 0; r < 3; ++r) {
+			for (unsigned int c = 0; c < 3; ++c) {
+				out.array[c + (r * 3)] = 0.0f;
+				for (unsigned int i = 0; i < 3; ++i) {
+					out.array[c + (r * 3)] += a.array[c + (i * 3)] * b.array[(r * 3) + i];
+				}
+			}
+		}
+		return out;
+	}
+
+	Vector4 Transform(const Matrix4& m, const Vector4& v) {
+		return Vector4(
+			v.x * m.array[0] + v.y * m.array[4] + v.z * m.array[8] + v.w * m.array[12],
+			v.x * m.array[1] + v.y * m.array[5] + v.z * m.array[9] + v.w * m.array[13],
+			v.x * m.array[2] + v.y * m.array[6] + v.z * m.array[10] + v.w * m.array[14],
+			v.x * m.array[3] + v.y * m.array[7] + v.z * m.array[11] + v.w * m.array[15]
+		);
+	}
+
+	Quaternion Multiply(const Quaternion& a, const Quaternion& b) {
+		return Quaternion(
+			(a.x * b.w) + (a.w * b.x) + (a.y * b.z) - (a.z * b.y),
+			(a.y * b.w) + (a.w * b.y) + (a.z * b.x) - (a.x * b.z),
+			(a.z * b.w) + (a.w * b.z) + (a.x * b.y) - (a.y * b.x),
+			(a.w * b.w) - (a.x * b.x) - (a.y * b.y) - (a.z * b.z)
+		);
+	}
+
+	Quaternion Slerp(const Quaternion& from, const Quaternion& to, float by) {
+		float c = (float)cos(by);
+		float d = (float)(1.0f - cos(by));
+		return Quaternion(from.x * c + to.x * d, from.y * c + to.y * d, from.z * c + to.z * d, from.w * c + to.w * d);
+	}
+
+	Quaternion Normalised(Quaternion q) {
+		float magnitude = sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+		if (magnitude > 0.0f) {
+			float t = 1.0f / magnitude;
+			q.x *= t;
+			q.y *= t;
+			q.z *= t;
+			q.w *= t;
+		}
+		return q;
+	}
+
+	Vector4 Normalised(Vector4 v) {
+		float length = sqrt((v.x * v.x) + (v.y * v.y) + (v.z * v.z));
+		if (length != 0.0f) {
+			length = 1.0f / length;
+			v.x *= length;
+			v.y *= length;
+			v.z *= length;
+			v.w *= length;
+		}
+		return v;
+	}
+}
+
+struct BenchmarkData {
+	std::vector<Matrix4>	matrices;
+	std::vector<Matrix4>	otherMatrices;
+	std::vector<Matrix3>	matrices3;
+	std::vector<Quaternion>	quats;
+	std::vector<Quaternion>	otherQuats;
+	std::vector<Vector3>	vec3s;
+	std::vector<Vector4>	vec4s;
+	std::vector<float>		amounts;
+
+	std::vector<Matrix4>	matrixResults;
+	std::vector<Matrix3>	matrix3Results;
+	std::vector<Quaternion>	quatResults;
+	std::vector<Vector3>	vec3Results;
+	std::vector<Vector4>	vec4Results;
+};
+
+// rotation, translation and scale, like the transforms the game actually builds
+Matrix4 RandomTransform(std::mt19937& rng) {
+	std::uniform_real_distribution<float> angle(-180.0f, 180.0f);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> scale(0.5f, 4.0f);
+
+	Quaternion q = Quaternion::EulerAnglesToQuaternion(angle(rng), angle(rng), angle(rng));
+	return Matrix4::Translation(Vector3(position(rng), position(rng), position(rng))) * Matrix4(q) * Matrix4::Scale(Vector3(scale(rng), scale(rng), scale(rng)));
+}
+
+void FillData(BenchmarkData& d) {
+	std::mt19937 rng(8503);
+	std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> angle(-180.0f, 180.0f);
+	std::uniform_real_distribution<float> amount(0.0f, 1.0f);
+
+	for (size_t i = 0; i < arraySize; ++i) {
+		d.matrices.emplace_back(RandomTransform(rng));
+		d.otherMatrices.emplace_back(RandomTransform(rng));
+		d.matrices3.emplace_back(Matrix3(d.matrices.back()));
+
+		d.quats.emplace_back(Quaternion::EulerAnglesToQuaternion(angle(rng), angle(rng), angle(rng)));
+		d.otherQuats.emplace_back(Quaternion::EulerAnglesToQuaternion(angle(rng), angle(rng), angle(rng)));
+
+		d.vec3s.emplace_back(Vector3(value(rng), value(rng), value(rng)));
+		d.vec4s.emplace_back(Vector4(value(rng), value(rng), value(rng), 1.0f));
+		d.amounts.emplace_back(amount(rng));
+	}
+	d.matrixResults.resize(arraySize);
+	d.matrix3Results.resize(arraySize);
+	d.quatResults.resize(arraySize);
+	d.vec3Results.resize(arraySize);
+	d.vec4Results.resize(arraySize);
+}
+
+// runs func(i) for every element, repeats times, and returns the best run in ns per call.
+// templated so the call inlines - a std::function would add an indirect call to every element
+template<typename Func>
+double TimeOperation(const Func& func) {
+	double best = 0.0;
+	for (int run = 0; run < runs; ++run) {
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int r = 0; r < repeats; ++r) {
+			for (size_t i = 0; i < arraySize; ++i) {
+				func(i);
+			}
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		double ns = std::chrono::duration<double, std::nano>(end - start).count() / ((double)repeats * arraySize);
+		if (run == 0 || ns < best) {
+			best = ns;
+		}
+	}
+	return best;
+}
+
+void PrintResult(const std::string& name, double libraryTime, double scalarTime = -1.0) {
+	std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(2);
+	std::cout << std::setw(10) << libraryTime;
+	if (scalarTime >= 0.0) {
+		std::cout << std::setw(10) << scalarTime << std::setw(9) << scalarTime / libraryTime << "x";
+	}
+	std::cout << std::endl;
+}
+
+// true if op gives exactly the same bits as ref for every element
+template<typename T>
+bool SameBits(const std::string& name, const std::function<T(size_t)>& op, const std::function<T(size_t)>& ref) {
+	for (size_t i = 0; i < arraySize; ++i) {
+		T a = op(i);
+		T b = ref(i);
+		if (std::memcmp(&a, &b, sizeof(T)) != 0) {
+			std::cout << name << " doesn't match the scalar code, first at element " << i << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+Strict mode promises the same results as the scalar code, so replays and networking stay
+deterministic whichever backend a machine has - this holds it to that. Fast mode only
+changes how things are normalised, so everything else is still checked.
+*/
+bool TestStrictMatchesScalar(const BenchmarkData& d) {
+	bool passed = true;
+	passed &= SameBits<Matrix4>("Matrix4 * Matrix4",
+		[&](size_t i) { return d.matrices[i] * d.otherMatrices[i]; },
+		[&](size_t i) { return Reference::Multiply(d.matrices[i], d.otherMatrices[i]); });
+	passed &= SameBits<Vector4>("Matrix4 * Vector4",
+		[&](size_t i) { return d.matrices[i] * d.vec4s[i]; },
+		[&](size_t i) { return Reference::Transform(d.matrices[i], d.vec4s[i]); });
+	passed &= SameBits<Matrix3>("Matrix3 * Matrix3",
+		[&](size_t i) { return d.matrices3[i] * d.matrices3[(i + 1) % arraySize]; },
+		[&](size_t i) { return Reference::Multiply(d.matrices3[i], d.matrices3[(i + 1) % arraySize]); });
+	passed &= SameBits<Quaternion>("Quaternion * Quaternion",
+		[&](size_t i) { return d.quats[i] * d.otherQuats[i]; },
+		[&](size_t i) { return Reference::Multiply(d.quats[i], d.otherQuats[i]); });
+	passed &= SameBits<Quaternion>("Quaternion::Slerp",
+		[&](size_t i) { return Quaternion::Slerp(d.quats[i], d.otherQuats[i], d.amounts[i]); },
+		[&](size_t i) { return Reference::Slerp(d.quats[i], d.otherQuats[i], d.amounts[i]); });
+#ifndef NCL_MATHS_FAST
+	passed &= SameBits<Quaternion>("Quaternion::Normalise",
+		[&](size_t i) { Quaternion q = d.quats[i] * d.amounts[i]; q.Normalise(); return q; },
+		[&](size_t i) { return Reference::Normalised(d.quats[i] * d.amounts[i]); });
+	passed &= SameBits<Vector4>("Vector4::Normalised",
+		[&](size_t i) { return d.vec4s[i].Normalised(); },
+		[&](size_t i) { return Reference::Normalised(d.vec4s[i]); });
+#endif
+	std::cout << std::endl << "Matches the scalar code: " << (passed ? "yes" : "NO - strict mode is broken") << std::endl;
+	return passed;
+}
+
+// angle between the rotations two unit quaternions make, in degrees
+float AngleBetween(const Quaternion& a, const Quaternion& b) {
+	float dot = std::min(std::fabs(Quaternion::Dot(a, b)), 1.0f);
+	return RadiansToDegrees(2.0f * std::acos(dot));
+}
+
+/*
+Packs and unpacks every test quaternion at each bit budget, and reports the worst and
+average angular error. -q has to come back as the same rotation as q (the sign flip
+the packing does), and as the same bits, or the networking code will think unmoved
+objects have turned. Returns false if any of that went wrong.
+*/
+bool TestQuaternionCompression(BenchmarkData& d) {
+	std::cout << std::endl << std::left << std::setw(36) << "smallest three" << std::right
+		<< std::setw(10) << "bits" << std::setw(12) << "max deg" << std::setw(12) << "avg deg" << std::setw(10) << "ns/op" << std::endl;
+
+	bool passed = true;
+	for (int componentBits = 6; componentBits <= CSC8503::QuaternionCompression::DEFAULT_COMPONENT_BITS; ++componentBits) {
+		float	maxError	= 0.0f;
+		double	totalError	= 0.0;
+		for (size_t i = 0; i < arraySize; ++i) {
+			Quaternion	q		= d.quats[i];
+			uint32_t	packed	= CSC8503::QuaternionCompression::Compress(q, componentBits);
+			Quaternion	out		= CSC8503::QuaternionCompression::Decompress(packed, componentBits);
+
+			float error = AngleBetween(q, out);
+			maxError	= std::max(maxError, error);
+			totalError	+= error;
+
+			if (packed != CSC8503::QuaternionCompression::Compress(-q, componentBits) ||
+				std::fabs(Quaternion::Dot(out, out) - 1.0f) > 0.0001f) {
+				passed = false;
+			}
+		}
+		double time = TimeOperation([&](size_t i) {
+			uint32_t packed = CSC8503::QuaternionCompression::Compress(d.quats[i], componentBits);
+			d.quatResults[i] = CSC8503::QuaternionCompression::Decompress(packed, componentBits);
+		});
+
+		std::string name = std::to_string(componentBits) + " bits per component";
+		std::cout << std::left << std::setw(36) << name << std::right << std::setw(10) << CSC8503::QuaternionCompression::TotalBits(componentBits)
+			<< std::setprecision(4) << std::setw(12) << maxError << std::setw(12) << totalError / arraySize
+			<< std::setprecision(2) << std::setw(10) << time << std::endl;
+	}
+	if (!passed) {
+		std::cout << "Quaternion compression FAILED - sign flips or normalisation are broken" << std::endl;
+	}
+	return passed;
+}
+
+int main() {
+	BenchmarkData d;
+	FillData(d);
+
+#if defined(NCL_SIMD_SSE)
+	std::string backend = "SSE";
+#elif defined(NCL_SIMD_NEON)
+	std::string backend = "NEON";
+#else
+	std::string backend = "scalar";
+#endif
+#ifdef NCL_MATHS_FAST
+	backend += " (fast)";
+#elif defined(NCL_SIMD_ENABLED)
+	backend += " (strict)";
+#endif
+	std::cout << "Maths library backend: " << backend << std::endl;
+	std::cout << arraySize << " elements, best of " << runs << " runs of " << repeats << " repeats" << std::endl << std::endl;
+	std::cout << std::left << std::setw(36) << "ns/op" << std::right << std::setw(10) << backend.substr(0, backend.find(' ')) << std::setw(10) << "scalar" << std::setw(10) << "speedup" << std::endl;
+
+	PrintResult("Matrix4 * Matrix4",
+		TimeOperation([&](size_t i) { d.matrixResults[i] = d.matrices[i] * d.otherMatrices[i]; }),
+		TimeOperation([&](size_t i) { d.matrixResults[i] = Reference::Multiply(d.matrices[i], d.otherMatrices[i]); }));
+
+	PrintResult("Matrix4 * Vector4",
+		TimeOperation([&](size_t i) { d.vec4Results[i] = d.matrices[i] * d.vec4s[i]; }),
+		TimeOperation([&](size_t i) { d.vec4Results[i] = Reference::Transform(d.matrices[i], d.vec4s[i]); }));
+
+	PrintResult("Matrix4 * Vector3",
+		TimeOperation([&](size_t i) { d.vec3Results[i] = d.matrices[i] * d.vec3s[i]; }));
+
+	PrintResult("Matrix4::Inverse",
+		TimeOperation([&](size_t i) { d.matrixResults[i] = d.matrices[i].Inverse(); }));
+
+	PrintResult("Matrix4::InverseRigid",
+		TimeOperation([&](size_t i) { d.matrixResults[i] = d.matrices[i].InverseRigid(); }));
+
+	PrintResult("Matrix4(Quaternion)",
+		TimeOperation([&](size_t i) { d.matrixResults[i] = Matrix4(d.quats[i]); }));
+
+	PrintResult("Matrix3 * Matrix3",
+		TimeOperation([&](size_t i) { d.matrix3Results[i] = d.matrices3[i] * d.matrices3[(i + 1) % arraySize]; }),
+		TimeOperation([&](size_t i) { d.matrix3Results[i] = Reference::Multiply(d.matrices3[i], d.matrices3[(i + 1) % arraySize]); }));
+
+	PrintResult("Quaternion * Quaternion",
+		TimeOperation([&](size_t i) { d.quatResults[i] = d.quats[i] * d.otherQuats[i]; }),
+		TimeOperation([&](size_t i) { d.quatResults[i] = Reference::Multiply(d.quats[i], d.otherQuats[i]); }));
+
+	PrintResult("Quaternion::Slerp",
+		TimeOperation([&](size_t i) { d.quatResults[i] = Quaternion::Slerp(d.quats[i], d.otherQuats[i], d.amounts[i]); }),
+		TimeOperation([&](size_t i) { d.quatResults[i] = Reference::Slerp(d.quats[i], d.otherQuats[i], d.amounts[i]); }));
+
+	PrintResult("Quaternion::Normalise",
+		TimeOperation([&](size_t i) { d.quatResults[i] = d.quats[i] * d.amounts[i]; d.quatResults[i].Normalise(); }),
+		TimeOperation([&](size_t i) { d.quatResults[i] = Reference::Normalised(d.quats[i] * d.amounts[i]); }));
+
+	PrintResult("Quaternion::EulerAnglesToQuaternion",
+		TimeOperation([&](size_t i) { d.quatResults[i] = Quaternion::EulerAnglesToQuaternion(d.vec3s[i].x, d.vec3s[i].y, d.vec3s[i].z); }));
+
+	PrintResult("Vector3::Normalised",
+		TimeOperation([&](size_t i) { d.vec3Results[i] = d.vec3s[i].Normalised(); }));
+
+	PrintResult("Vector4::Normalised",
+		TimeOperation([&](size_t i) { d.vec4Results[i] = d.vec4s[i].Normalised(); }),
+		TimeOperation([&](size_t i) { d.vec4Results[i] = Reference::Normalised(d.vec4s[i]); }));
+
+	bool passed = TestStrictMatchesScalar(d);
+	passed &= TestQuaternionCompression(d);
+
+	// read everything back, so none of the work above can be optimised away
+	float total = 0.0f;
+	for (size_t i = 0; i < arraySize; ++i) {
+		total += d.matrixResults[i].array[0] + d.matrix3Results[i].array[0] + d.quatResults[i].w + d.vec3Results[i].x + d.vec4Results[i].x;
+	}
+	benchmarkSink = total;
+
+	return passed ? 0 : 1;
+}